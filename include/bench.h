@@ -0,0 +1,91 @@
+/**
+ * @file bench.h
+ * @brief Benchmark de débit séquentiel par palier de fréquence SPI
+ *
+ * Pour chaque fréquence de la table de repli, la zone de tête de
+ * SCRATCH.BIN est écrite puis relue secteur par secteur (CMD24/CMD17),
+ * puis d'un seul flux (CMD25/CMD18). Chaque passe donne le débit soutenu,
+ * les percentiles de latence par secteur et la part du temps passée à
+ * attendre la fin de programmation de la carte.
+ *
+ * Viennent ensuite deux passes aléatoires de secteurs isolés (écriture puis
+ * lecture, même séquence d'adresses à graine fixe) à la fréquence courante:
+ * IOPS, latence de queue et plus longue attente de programmation, le
+ * profil des petites mises à jour de métadonnées en production.
+ *
+ * Avec ERASE_ENABLED, la zone est effacée avant chaque passe d'écriture:
+ * toutes les fréquences partent du même état de la carte.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Mode d'accès d'une passe
+ */
+typedef enum {
+    BENCH_SINGLE = 0,       // Une commande par secteur
+    BENCH_MULTI = 1,        // Un flux multi-bloc pour toute la zone
+    BENCH_RANDOM = 2        // Secteurs isolés à adresses aléatoires
+} bench_mode_t;
+
+/**
+ * Résultat d'une passe
+ */
+typedef struct {
+    uint32_t freq_hz;
+    uint8_t mode;           // bench_mode_t
+    bool is_write;
+    uint32_t sectors;       // Secteurs transférés
+    uint32_t time_us;       // Durée des transferts
+    uint32_t busy_us;       // Dont attente de fin de programmation
+    uint32_t p50_us;        // Latence par secteur (borne basse de la classe)
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+    uint32_t max_us;
+    uint32_t busy_max_us;   // Plus longue attente de programmation
+    uint32_t erase_us;      // Effacement préalable de la zone (hors durée)
+    uint32_t errors;
+} bench_result_t;
+
+/**
+ * @brief Exécute toutes les passes puis écrit BENCH_RESULTS_FILE
+ *
+ * La carte doit être montée. La fréquence SPI est restaurée à la fin.
+ *
+ * @return ERR_NONE, ou l'erreur d'ouverture / d'écriture des résultats
+ */
+sd_error_t bench_run(void);
+
+/**
+ * @brief Accès aux résultats de la dernière exécution
+ *
+ * @param results Reçoit le tableau des résultats
+ * @return Nombre de passes
+ */
+uint8_t bench_get_results(const bench_result_t** results);
+
+/**
+ * @brief Histogramme de latence d'une passe aléatoire
+ *
+ * @param is_write Passe d'écriture (true) ou de lecture (false)
+ * @param hist Reçoit les compteurs par classe
+ * @return Nombre de classes
+ */
+uint8_t bench_get_random_hist(bool is_write, const uint16_t** hist);
+
+/**
+ * @brief Borne basse d'une classe de l'histogramme de latence (µs)
+ */
+uint32_t bench_hist_floor(uint8_t bucket);
+
+/**
+ * @brief Nom d'un mode d'accès ("single", "multi", "random")
+ */
+const char* bench_mode_name(uint8_t mode);
+
+#endif // BENCH_H
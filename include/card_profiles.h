@@ -0,0 +1,29 @@
+/**
+ * @file card_profiles.h
+ * @brief Profils de réglage par lot de cartes SD, identifiés par le CID
+ *
+ * Chaque lot qualifié démarre directement avec ses réglages au lieu des
+ * valeurs par défaut de config.h. Le premier profil correspondant est
+ * retenu: placer les entrées les plus précises (produit) avant les
+ * entrées génériques (fabricant seul).
+ *
+ * Champs à 0 / chaîne vide = joker (voir card_profile_t dans config.h).
+ * Inclus uniquement par sd_controller.cpp.
+ */
+
+#ifndef CARD_PROFILES_H
+#define CARD_PROFILES_H
+
+#include "config.h"
+
+static const card_profile_t CARD_PROFILES[] = {
+    // MID   OID   PNM      SPI        settle  batch
+    { 0x03, "SD", "",      4000000UL,  50,     1 },   // SanDisk
+    { 0x02, "TM", "",      4000000UL, 100,     1 },   // Toshiba / Kioxia
+    { 0x1B, "SM", "",      4000000UL, 100,     1 },   // Samsung
+    { 0x27, "PH", "",      1000000UL, 200,     1 },   // Phison (lots génériques)
+};
+
+#define CARD_PROFILE_COUNT  (sizeof(CARD_PROFILES) / sizeof(CARD_PROFILES[0]))
+
+#endif // CARD_PROFILES_H
@@ -0,0 +1,86 @@
+/**
+ * @file churn.h
+ * @brief Charge de test des métadonnées FAT (création, complément,
+ *        troncature, renommage, suppression de petits fichiers)
+ *
+ * Chaque cycle tire CHURN_OPS_PER_CYCLE noms au hasard parmi
+ * CHURN_MAX_FILES dans le sous-répertoire CHURN_DIR_NAME: un nom absent
+ * est créé, un nom présent subit l'une des autres opérations. Le répertoire
+ * grossit jusqu'à un équilibre, entrées supprimées comprises, ce qui met en
+ * évidence le coût du parcours linéaire sur les volumes à petits clusters.
+ */
+
+#ifndef CHURN_H
+#define CHURN_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Opérations de la charge
+ */
+typedef enum {
+    CHURN_CREATE = 0,
+    CHURN_APPEND,
+    CHURN_TRUNCATE,
+    CHURN_RENAME,
+    CHURN_DELETE,
+    CHURN_OP_COUNT
+} churn_op_t;
+
+/**
+ * Classes de taille du répertoire parcouru: [2^i, 2^(i+1)) secteurs
+ */
+#define CHURN_SIZE_CLASSES  8
+
+/**
+ * Latence cumulée d'un type d'opération
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t errors;
+    uint64_t scan_us;
+    uint64_t entry_us;
+    uint64_t fat_us;
+    uint64_t data_us;
+    uint32_t max_us;                // Pire opération complète
+} churn_op_stats_t;
+
+/**
+ * Parcours du répertoire par taille
+ */
+typedef struct {
+    uint32_t ops;
+    uint64_t scan_us;
+} churn_size_stats_t;
+
+/**
+ * Statistiques de la charge de métadonnées
+ */
+typedef struct {
+    churn_op_stats_t ops[CHURN_OP_COUNT];
+    churn_size_stats_t sizes[CHURN_SIZE_CLASSES];
+    uint16_t files;                 // Population connue
+    uint32_t max_dir_sectors;       // Plus long parcours
+} churn_stats_t;
+
+/**
+ * @brief Réinitialise les statistiques et l'état connu des fichiers
+ */
+void churn_init(void);
+
+/**
+ * @brief Exécute les opérations du cycle
+ *
+ * La carte doit être montée. Ouvre (ou crée) le répertoire au premier appel.
+ *
+ * @return ERR_NONE, ou l'erreur de la première opération échouée
+ */
+sd_error_t churn_run_cycle(void);
+
+/**
+ * @brief Accès aux statistiques
+ */
+const churn_stats_t* churn_get_stats(void);
+
+#endif // CHURN_H
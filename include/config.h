@@ -127,12 +127,281 @@
  */
 #define SD_RETRY_DELAY_MS       100
 
+/**
+ * Formatage rapide au démarrage si le bouton utilisateur est maintenu:
+ * MBR et début des données alignés sur l'AU (FORMAT_ALIGN_SECTORS si elle
+ * est inconnue), FAT32 en clusters de FORMAT_CLUSTER_SECTORS (réduits si
+ * la carte est trop petite), journal préalloué de FORMAT_LOG_PREALLOC_SECTORS
+ */
+#ifndef FORMAT_ENABLED
+#define FORMAT_ENABLED      0
+#endif
+
+#ifndef FORMAT_CLUSTER_SECTORS
+#define FORMAT_CLUSTER_SECTORS      64      // 32 Ko
+#endif
+
+#ifndef FORMAT_ALIGN_SECTORS
+#define FORMAT_ALIGN_SECTORS        8192UL  // 4 Mo
+#endif
+
+#ifndef FORMAT_LOG_PREALLOC_SECTORS
+#define FORMAT_LOG_PREALLOC_SECTORS 32768UL // 16 Mo
+#endif
+
+/**
+ * Effacer (CMD32/33/38) les clusters des journaux supprimés par la rotation
+ * et la zone de benchmark avant chaque passe d'écriture: la carte n'a plus
+ * à préserver ces blocs, l'écriture suivante attend moins longtemps
+ */
+#ifndef ERASE_ENABLED
+#define ERASE_ENABLED       1
+#endif
+
+/**
+ * Délai maximal d'un effacement (ms) si le registre SD Status n'en donne pas
+ */
+#define ERASE_TIMEOUT_MS    2000
+
+/**
+ * Intervalle de sauvegarde des statistiques sur la carte (cycles)
+ * Les statistiques sont aussi sauvegardées juste avant un reboot automatique
+ * et restaurées au démarrage (0 = désactivé)
+ */
+#ifndef CHECKPOINT_INTERVAL_CYCLES
+#define CHECKPOINT_INTERVAL_CYCLES  100
+#endif
+
+/**
+ * Nombre minimum de secteurs réservés du volume pour héberger les deux
+ * secteurs de checkpoint (A/B) et l'index de rotation du journal en fin de
+ * zone réservée, après les secteurs de boot, FSInfo et leurs copies de secours
+ */
+#define CHECKPOINT_MIN_RESERVED     16
+
 /**
  * Activer le fallback automatique de fréquence SPI
  * Si l'init échoue, réduit la fréquence et réessaye
  */
 #define SPI_FREQUENCY_FALLBACK  1
 
+// =============================================================================
+// CONFIGURATION CHARGE D'E/S (WORKLOAD)
+// =============================================================================
+
+/**
+ * Exécuter en plus de la ligne CSV une charge d'E/S dans SCRATCH.BIN
+ */
+#ifndef WORKLOAD_ENABLED
+#define WORKLOAD_ENABLED    0
+#endif
+
+/**
+ * Taille du fichier de travail (secteurs), alloué contigu au premier usage
+ * 8192 = 4 Mo
+ */
+#ifndef WORKLOAD_SCRATCH_SECTORS
+#define WORKLOAD_SCRATCH_SECTORS    8192UL
+#endif
+
+/**
+ * Tailles d'opération (octets, 1 à 65536), parcourues à tour de rôle avec
+ * chaque motif (séquentiel, aléatoire)
+ */
+#ifndef WORKLOAD_SIZES
+#define WORKLOAD_SIZES      1, 64, 512, 4096, 32768, 65536
+#endif
+
+/**
+ * Proportion de lectures (%)
+ */
+#ifndef WORKLOAD_READ_PERCENT
+#define WORKLOAD_READ_PERCENT   30
+#endif
+
+/**
+ * Opérations par cycle
+ */
+#ifndef WORKLOAD_OPS_PER_CYCLE
+#define WORKLOAD_OPS_PER_CYCLE  8
+#endif
+
+// =============================================================================
+// CONFIGURATION CHARGE DE MÉTADONNÉES (CHURN)
+// =============================================================================
+
+/**
+ * Créer, compléter, tronquer, renommer et supprimer à chaque cycle des
+ * petits fichiers dans un sous-répertoire dédié, avec la latence de chaque
+ * étape (parcours du répertoire, écriture d'entrée, FAT, données)
+ */
+#ifndef CHURN_ENABLED
+#define CHURN_ENABLED       0
+#endif
+
+/**
+ * Sous-répertoire de travail (nom 8.3 du répertoire)
+ */
+#ifndef CHURN_DIR_NAME
+#define CHURN_DIR_NAME      "CHURN      "
+#endif
+
+/**
+ * Nombre de noms de fichiers possibles (CH000000.DAT ...): la population
+ * se stabilise vers 3/4 de cette valeur
+ */
+#ifndef CHURN_MAX_FILES
+#define CHURN_MAX_FILES     256
+#endif
+
+/**
+ * Opérations par cycle et octets ajoutés par complément
+ */
+#ifndef CHURN_OPS_PER_CYCLE
+#define CHURN_OPS_PER_CYCLE 8
+#endif
+
+#ifndef CHURN_APPEND_BYTES
+#define CHURN_APPEND_BYTES  700
+#endif
+
+// =============================================================================
+// CONFIGURATION VÉRIFICATION PAR RELECTURE
+// =============================================================================
+
+/**
+ * Écrire à chaque cycle un secteur de contrôle (PRBS, séquence, CRC) et
+ * relire les derniers écrits pour détecter les corruptions silencieuses
+ */
+#ifndef VERIFY_ENABLED
+#define VERIFY_ENABLED      0
+#endif
+
+/**
+ * Taille de l'anneau de secteurs de contrôle, placé après la zone de
+ * charge dans SCRATCH.BIN
+ */
+#ifndef VERIFY_RING_SECTORS
+#define VERIFY_RING_SECTORS     256UL
+#endif
+
+/**
+ * Secteurs relus par cycle (K), le plus récent compris
+ * Les plus anciens ont survécu à K-1 coupures en mode agressif
+ */
+#ifndef VERIFY_READBACK_SECTORS
+#define VERIFY_READBACK_SECTORS 4
+#endif
+
+/**
+ * Fréquences SPI distinctes suivies dans les statistiques de corruption
+ */
+#ifndef VERIFY_FREQ_SLOTS
+#define VERIFY_FREQ_SLOTS       6
+#endif
+
+// =============================================================================
+// CONFIGURATION BENCHMARK
+// =============================================================================
+
+/**
+ * Benchmark au démarrage, avant le test de stress: débit séquentiel à
+ * chaque fréquence de la table de repli, puis IOPS aléatoires à la
+ * fréquence courante. Résultats sur le port série et dans BENCH_RESULTS_FILE
+ */
+#ifndef BENCH_ENABLED
+#define BENCH_ENABLED       0
+#endif
+
+/**
+ * Zone parcourue par passe (secteurs), en tête de SCRATCH.BIN
+ * 1024 = 512 Ko
+ */
+#ifndef BENCH_SEQ_SECTORS
+#define BENCH_SEQ_SECTORS   1024UL
+#endif
+
+/**
+ * Passes aléatoires (512 o, CMD24/CMD17): fenêtre en tête de SCRATCH.BIN,
+ * nombre d'opérations par passe et graine (séquence reproductible)
+ */
+#ifndef BENCH_RANDOM_WINDOW_SECTORS
+#define BENCH_RANDOM_WINDOW_SECTORS 8192UL
+#endif
+
+#ifndef BENCH_RANDOM_OPS
+#define BENCH_RANDOM_OPS    1000
+#endif
+
+#ifndef BENCH_RANDOM_SEED
+#define BENCH_RANDOM_SEED   0x5EEDC0DEUL
+#endif
+
+/**
+ * Fichier de résultats (nom 8.3 du répertoire)
+ */
+#ifndef BENCH_RESULTS_FILE
+#define BENCH_RESULTS_FILE  "BENCH   CSV"
+#endif
+
+/**
+ * Taille maximale du rapport (octets), formaté dans l'arena de travail
+ */
+#define BENCH_REPORT_BYTES  1536
+
+// =============================================================================
+// CONFIGURATION ENDURANCE
+// =============================================================================
+
+/**
+ * Écrire et vérifier sans relâche une petite fenêtre de secteurs jusqu'à la
+ * première erreur non corrigible (relecture fausse après réécriture).
+ * Le test s'arrête alors comme sur appui du bouton.
+ */
+#ifndef ENDURANCE_ENABLED
+#define ENDURANCE_ENABLED   0
+#endif
+
+/**
+ * Secteurs de la fenêtre (1 à 64), en fin de SCRATCH.BIN
+ */
+#ifndef ENDURANCE_SECTORS
+#define ENDURANCE_SECTORS   8
+#endif
+
+/**
+ * Passes (écriture + relecture de toute la fenêtre) par cycle
+ */
+#ifndef ENDURANCE_PASSES_PER_CYCLE
+#define ENDURANCE_PASSES_PER_CYCLE  32
+#endif
+
+/**
+ * Passes entre deux points de la courbe d'usure
+ */
+#ifndef ENDURANCE_RECORD_INTERVAL
+#define ENDURANCE_RECORD_INTERVAL   1000UL
+#endif
+
+/**
+ * Fichier de la courbe d'usure: secteur d'état, réécrit à chaque cycle, puis
+ * enregistrements de 12 octets (passes, attente moyenne et maximale de
+ * programmation en µs), 42 par secteur: 64 secteurs = 2646 points
+ */
+#ifndef ENDURANCE_LOG_FILE
+#define ENDURANCE_LOG_FILE  "WEAR    BIN"
+#endif
+
+#ifndef ENDURANCE_LOG_SECTORS
+#define ENDURANCE_LOG_SECTORS   64
+#endif
+
+/**
+ * Taille totale du fichier de travail: zone de charge, anneau de contrôle,
+ * puis fenêtre d'endurance
+ */
+#define SCRATCH_FILE_SECTORS    (WORKLOAD_SCRATCH_SECTORS + VERIFY_RING_SECTORS + ENDURANCE_SECTORS)
+
 // =============================================================================
 // CONFIGURATION FICHIER CSV
 // =============================================================================
@@ -144,6 +413,32 @@
 #define CSV_FILENAME        "/sd_test.csv"
 #endif
 
+/**
+ * Rotation du journal: SD_00001.CSV, SD_00002.CSV... au lieu de CSV_FILENAME
+ * Un nouveau fichier est ouvert avant la ligne qui dépasserait l'un des
+ * seuils (0 = seuil inactif). Le fichier actif est retrouvé au montage par
+ * un secteur d'index en zone réservée, sans parcourir le répertoire.
+ */
+#ifndef LOG_ROTATE_ENABLED
+#define LOG_ROTATE_ENABLED  0
+#endif
+
+#ifndef LOG_ROTATE_BYTES
+#define LOG_ROTATE_BYTES    4194304UL
+#endif
+
+#ifndef LOG_ROTATE_CYCLES
+#define LOG_ROTATE_CYCLES   0
+#endif
+
+/**
+ * Nombre de fichiers conservés, actif compris: le plus ancien est supprimé
+ * à chaque rotation (0 = tout conserver)
+ */
+#ifndef LOG_ROTATE_KEEP
+#define LOG_ROTATE_KEEP     0
+#endif
+
 /**
  * Taille maximale de la ligne CSV (bytes)
  * Format: timestamp,cycle,status,error_code,init_time_ms,write_time_ms,spi_freq
@@ -158,7 +453,165 @@
 /**
  * En-tête du fichier CSV
  */
-#define CSV_HEADER          "timestamp_ms,cycle,status,error_code,init_time_us,write_time_us,spi_freq_hz,vbat_mv,free_heap\n"
+#define CSV_HEADER          "timestamp_ms,cycle,status,error_code,init_time_us,write_time_us,spi_freq_hz,vbat_mv,free_heap,boot_epoch,card_serial\n"
+
+/**
+ * Mode continu: nombre de lignes entre deux mises à jour de la taille du
+ * fichier dans le répertoire (toujours mise à jour au démontage)
+ */
+#ifndef CSV_SIZE_UPDATE_LINES
+#define CSV_SIZE_UPDATE_LINES   16
+#endif
+
+/**
+ * Fichiers texte annexes ouverts en même temps que le journal CSV (1 à 4,
+ * 0 = désactivé). Chacun garde sa position et sa dernière suite de
+ * clusters; tous partagent le secteur de fin en RAM du journal, réécrit
+ * sur la carte quand un autre fichier le reprend.
+ */
+#ifndef FILE_HANDLE_COUNT
+#define FILE_HANDLE_COUNT   2
+#endif
+
+/**
+ * Résumé des statistiques ajouté à chaque checkpoint (nom 8.3 du
+ * répertoire, "" = désactivé)
+ */
+#ifndef STATS_SUMMARY_FILE
+#define STATS_SUMMARY_FILE  "SUMMARY TXT"
+#endif
+
+/**
+ * Événements (échecs de cycle, reboots) ajoutés au fil de l'eau
+ * ("" = désactivé)
+ */
+#ifndef EVENT_LOG_FILE
+#define EVENT_LOG_FILE      "EVENTS  TXT"
+#endif
+
+/**
+ * Événements en attente de la carte (octets): en mode agressif la carte
+ * est démontée après un échec, les lignes sont écrites au checkpoint
+ * suivant. Buffer plein: les nouveaux événements sont perdus.
+ */
+#define EVENT_BUFFER_SIZE   256
+
+/**
+ * Nombre maximum de clusters parcourus dans la chaîne d'un répertoire
+ * Borne le temps de montage sur une carte très remplie ou corrompue
+ */
+#define DIR_MAX_CLUSTERS    64
+
+/**
+ * Taille de la bitmap des clusters libres (octets, 1 bit par cluster)
+ * 64 octets = fenêtre de 512 clusters, soit 4 secteurs de FAT par rechargement
+ * Puissance de 2, au moins 32 (un secteur de FAT16 entier)
+ */
+#ifndef FREE_BITMAP_BYTES
+#define FREE_BITMAP_BYTES   64
+#endif
+
+/**
+ * Nombre de lignes accumulées en RAM dans le secteur de fin avant écriture
+ * 1 = écriture à chaque ligne; le secteur est toujours écrit quand il est
+ * plein et au démontage
+ */
+#ifndef CSV_FLUSH_BATCH_LINES
+#define CSV_FLUSH_BATCH_LINES   1
+#endif
+
+/**
+ * Nombre maximum d'extents (suites de clusters contigus) du fichier CSV en RAM
+ * 12 octets par extent; au-delà les plus anciens sont oubliés (le premier et
+ * la fin du fichier restent adressables)
+ */
+#ifndef LOG_EXTENT_MAX
+#define LOG_EXTENT_MAX      16
+#endif
+
+/**
+ * Nombre de secteurs de FAT gardés en cache (1 ou 2, 512 octets chacun)
+ * Les mises à jour de chaîne sont regroupées jusqu'au flush
+ */
+#ifndef FAT_CACHE_ENTRIES
+#define FAT_CACHE_ENTRIES   2
+#endif
+
+/**
+ * 1 = n'écrire que la FAT #1 pendant l'enregistrement et recopier les autres
+ * FAT au démontage (moins d'écritures, copies en retard en cas de coupure)
+ */
+#ifndef FAT_MIRROR_DEFERRED
+#define FAT_MIRROR_DEFERRED 0
+#endif
+
+/**
+ * Volumes exFAT (cartes SDXC telles que livrées): le journal y est un
+ * fichier contigu sans chaîne FAT (NoFatChain), prolongé par la bitmap
+ * d'allocation. Rotation, checkpoints et fichiers des charges de test
+ * restent réservés à FAT16/FAT32.
+ */
+#ifndef EXFAT_ENABLED
+#define EXFAT_ENABLED       1
+#endif
+
+/**
+ * Carte de latence du journal: attente de programmation moyenne et
+ * maximale par tranche de secteurs (8 octets par tranche). La largeur des
+ * tranches double quand le journal dépasse la couverture.
+ * Une tranche est lente si sa moyenne dépasse LATENCY_MAP_SLOW_FACTOR fois
+ * la médiane des tranches.
+ */
+#ifndef LATENCY_MAP_BUCKETS
+#define LATENCY_MAP_BUCKETS     32
+#endif
+
+#ifndef LATENCY_MAP_SLOW_FACTOR
+#define LATENCY_MAP_SLOW_FACTOR 4
+#endif
+
+/**
+ * Nombre maximum de secteurs relus depuis la fin du log pour retrouver le
+ * dernier enregistrement (reprise de la numérotation après reboot)
+ */
+#define LOG_RESUME_MAX_SECTORS  4
+
+/**
+ * En-tête de secteur du journal
+ * Chaque secteur de 512 octets du fichier commence par une ligne de
+ * commentaire "#SDL <génération> <séquence>\n" (hexadécimal, 23 octets).
+ * Une ligne CSV ne chevauche jamais deux secteurs: la fin d'un secteur
+ * incomplet est bourrée de '\n'. Au montage, le dernier secteur écrit est
+ * retrouvé par recherche dichotomique sur la séquence, sans scan linéaire.
+ * Lecture sur PC: ignorer les lignes commençant par '#' et les lignes vides.
+ */
+#define LOG_SECTOR_MAGIC    "#SDL"
+#define LOG_SECTOR_HDR_SIZE 23
+
+// =============================================================================
+// CONFIGURATION DIAGNOSTIC
+// =============================================================================
+
+/**
+ * Profondeur de la trace des dernières commandes SD (SPI)
+ */
+#define SD_TRACE_DEPTH      8
+
+/**
+ * Nombre de résultats de cycle conservés dans l'anneau de crash en RAM
+ * L'anneau survit aux resets logiciels (HW_Reset) et est vidé sur le port
+ * série et dans le CSV au boot suivant
+ */
+#ifndef CRASH_RING_ENTRIES
+#define CRASH_RING_ENTRIES  8
+#endif
+
+/**
+ * Section RAM non initialisée au démarrage pour l'anneau de crash
+ */
+#ifndef CRASH_RING_SECTION
+#define CRASH_RING_SECTION  ".noinit"
+#endif
 
 // =============================================================================
 // CONFIGURATION LOGGING
@@ -184,6 +637,54 @@
 #define SERIAL_DEBUG        1
 #endif
 
+/**
+ * Taille maximale d'un message formaté (LOG_*)
+ */
+#define LOG_LINE_MAX_SIZE   128
+
+// =============================================================================
+// CONFIGURATION RAM
+// =============================================================================
+
+/**
+ * Copie de la carte de latence affichée avec les statistiques (octets)
+ */
+#define RAM_LATENCY_MAP_BYTES   (LATENCY_MAP_BUCKETS * sizeof(sd_latency_bucket_t))
+
+/**
+ * Arena de travail partagée (octets): tampons de secteur des charges de
+ * test, lignes CSV, messages de log et copie de la carte de latence y sont
+ * empruntés le temps d'un appel au lieu d'occuper chacun de la RAM statique
+ * ou de la pile. Dimensionnée pour l'imbrication la plus profonde: un
+ * secteur, une ligne, un message (charges de test), le rapport de benchmark
+ * et un message, ou deux lignes et un message (vidage du crash ring), et au
+ * moins la carte de latence, empruntée seule. Le secteur n'est réservé que
+ * si une charge de test l'emprunte.
+ */
+#ifndef RAM_ARENA_BYTES
+#if BENCH_ENABLED
+#define RAM_ARENA_NESTED_BYTES  (BENCH_REPORT_BYTES + LOG_LINE_MAX_SIZE)
+#elif WORKLOAD_ENABLED || VERIFY_ENABLED || ENDURANCE_ENABLED
+#define RAM_ARENA_NESTED_BYTES  (512 + CSV_LINE_MAX_SIZE + LOG_LINE_MAX_SIZE)
+#else
+#define RAM_ARENA_NESTED_BYTES  (2 * CSV_LINE_MAX_SIZE + LOG_LINE_MAX_SIZE)
+#endif
+#define RAM_ARENA_BYTES     (RAM_ARENA_NESTED_BYTES > RAM_LATENCY_MAP_BYTES ? \
+                             RAM_ARENA_NESTED_BYTES : RAM_LATENCY_MAP_BYTES)
+#endif
+
+/**
+ * Peinture de la pile au démarrage pour en mesurer la profondeur maximale:
+ * la zone entre la fin du tas et la pile courante est remplie d'un motif,
+ * la première partie écrasée donne le point le plus bas atteint.
+ * RAM_HEAP_RESERVE octets sont laissés au tas (allocations du framework).
+ */
+#ifndef RAM_STACK_PAINT
+#define RAM_STACK_PAINT     1
+#endif
+
+#define RAM_HEAP_RESERVE    256
+
 // =============================================================================
 // CODES D'ERREUR
 // =============================================================================
@@ -202,9 +703,19 @@ typedef enum {
     ERR_SD_CARD_TYPE_UNKNOWN = 10,
     ERR_FAT_VOLUME_FAILED = 11,
     ERR_BUFFER_OVERFLOW = 12,
+    ERR_FILE_READ_FAILED = 13,
+    ERR_VOLUME_FULL = 14,
+    ERR_SECTOR_WORN = 15,
+    ERR_FILE_EXISTS = 16,
     ERR_UNKNOWN = 255
 } sd_error_t;
 
+/**
+ * Nombre de classes de l'histogramme des temps d'écriture
+ * Classe i = temps dans [2^i, 2^(i+1)) µs, la dernière regroupe le reste
+ */
+#define STATS_HIST_BUCKETS  20
+
 /**
  * Structure pour les statistiques de test
  */
@@ -222,6 +733,11 @@ typedef struct {
     uint32_t spi_fallback_count;
     sd_error_t last_error;
     uint32_t current_spi_freq;
+    uint32_t boot_epoch;            // Nombre de boots depuis la création du log
+    uint32_t reboot_count;          // Reboots automatiques après échecs
+    uint32_t write_time_hist[STATS_HIST_BUCKETS];  // Histogramme log2 des temps d'écriture
+    uint32_t checkpoint_count;      // Checkpoints écrits (hors statistiques d'écriture)
+    uint32_t checkpoint_time_us;    // Durée du dernier checkpoint
 } test_stats_t;
 
 /**
@@ -235,6 +751,139 @@ typedef struct {
     uint32_t spi_freq_used;
 } cycle_result_t;
 
+/**
+ * Entrée de la trace des dernières commandes SD envoyées
+ */
+typedef struct {
+    uint32_t arg;
+    uint8_t cmd;
+    uint8_t response;
+} sd_trace_entry_t;
+
+/**
+ * Structure pour les métriques du système de fichiers (dernier montage)
+ */
+typedef struct {
+    uint32_t volume_start;          // Premier secteur du volume FAT
+    uint32_t volume_detect_reads;   // Secteurs lus pour le localiser (0 = géométrie en cache)
+    uint8_t partition_type;         // Type MBR (0x04, 0x06, 0x0E, 0x0B, 0x0C, 0x07), 0 = carte sans partition
+    uint8_t fat_bits;               // 16 ou 32 selon le BPB, 0 = exFAT
+    uint32_t recovery_probes;       // Secteurs lus pour retrouver la fin du log
+    uint32_t recovery_time_us;      // Durée de la recherche de fin de log
+    uint32_t log_tail_sector;       // Séquence du dernier secteur écrit
+    uint16_t log_tail_offset;       // Octets utilisés dans ce secteur
+    uint32_t dir_lookup_sectors;    // Secteurs de répertoire lus pour trouver le fichier
+    uint32_t dir_lookup_time_us;    // Durée de la recherche dans le répertoire
+    bool dir_cache_hit;             // Entrée retrouvée via l'emplacement mémorisé
+    uint32_t alloc_count;           // Clusters alloués (cumulé)
+    uint32_t alloc_total_us;        // Durée cumulée des allocations
+    uint32_t alloc_max_us;          // Allocation la plus lente
+    uint32_t alloc_fat_reads;       // Secteurs de FAT lus pour remplir la bitmap
+    uint32_t fat_writes;            // Secteurs de FAT écrits, toutes copies (cumulé)
+    uint32_t fat_cache_hits;        // Accès FAT servis par le cache
+    uint32_t fat_cache_misses;      // Accès FAT ayant nécessité une lecture
+    uint32_t log_bytes_appended;    // Octets ajoutés au journal (cumulé)
+    uint32_t log_extents;           // Extents de la chaîne du fichier CSV
+    uint32_t log_extents_dropped;   // Extents anciens sortis de la table
+    uint32_t au_same_writes;        // Écritures du journal dans la même AU que la précédente
+    uint32_t au_crossings;          // Écritures du journal ayant changé d'AU
+    uint32_t latency_slow_buckets;  // Tranches lentes de la carte de latence
+    uint32_t log_file_number;       // Numéro du fichier actif (rotation, 0 = inactive)
+    uint32_t log_rotations;         // Rotations depuis le démarrage
+    uint32_t log_rotate_time_us;    // Durée de la dernière rotation
+    uint32_t log_index_scan_sectors;// Secteurs lus faute d'index valide (0 = index utilisé)
+    uint32_t erase_count;           // Commandes d'effacement (cumulé)
+    uint32_t erase_sectors;         // Secteurs effacés
+    uint32_t erase_total_us;
+    uint32_t erase_max_us;
+    uint32_t erase_errors;
+    uint32_t tail_switches;         // Secteur de fin passé d'un fichier ouvert à un autre
+    uint32_t tail_reloads;          // Secteurs partiels relus à ces passages
+} sd_fs_stats_t;
+
+/**
+ * Géométrie et durée d'un formatage (sd_format)
+ */
+typedef struct {
+    uint32_t partition_start;       // Premier secteur de la partition
+    uint32_t partition_sectors;
+    uint32_t align_sectors;         // Alignement retenu (AU de la carte ou défaut)
+    uint32_t data_start;            // Premier secteur de données (absolu)
+    uint32_t fat_sectors;           // Par copie
+    uint32_t clusters;
+    uint32_t log_sectors;           // Préallocation du journal
+    uint32_t time_us;
+    uint16_t reserved_sectors;
+    uint8_t cluster_sectors;
+} sd_format_info_t;
+
+/**
+ * Décomposition du temps d'une opération de métadonnées (cumulée)
+ */
+typedef struct {
+    uint32_t scan_us;               // Parcours du répertoire
+    uint32_t entry_us;              // Écriture de l'entrée
+    uint32_t fat_us;                // Parcours, allocation et libération de chaîne
+    uint32_t data_us;               // Données du fichier
+    uint32_t dir_sectors;           // Secteurs de répertoire lus
+} sd_meta_timing_t;
+
+/**
+ * Tranche de la carte de latence du journal
+ */
+typedef struct {
+    uint32_t first_sequence;        // Premier secteur logique du journal couvert
+    uint16_t writes;
+    uint16_t avg_busy_us;
+    uint16_t max_busy_us;
+    bool slow;                      // Moyenne > LATENCY_MAP_SLOW_FACTOR x médiane
+} sd_latency_bucket_t;
+
+/**
+ * Identification et capacité de la carte (registres CID et CSD)
+ */
+typedef struct {
+    uint32_t serial;                // PSN
+    uint32_t sectors;               // Capacité réelle (secteurs de 512 octets)
+    uint32_t tran_speed_khz;        // Fréquence max annoncée (TRAN_SPEED)
+    uint16_t mfg_year;
+    uint8_t mfg_month;
+    uint8_t manufacturer_id;        // MID
+    char oem_id[3];                 // OID
+    char product[6];                // PNM
+    uint8_t revision;               // PRV (BCD n.m)
+    uint8_t taac;                   // Temps d'accès en lecture (code CSD)
+    uint8_t nsac;                   // Temps d'accès en lecture (cycles x100)
+    uint8_t r2w_factor;             // Écriture = lecture x 2^r2w_factor
+    uint8_t write_bl_len;           // log2 de la taille de bloc d'écriture
+    uint16_t erase_unit_sectors;    // Plus petit effacement (1 si ERASE_BLK_EN, sinon SECTOR_SIZE)
+    bool valid;
+} sd_card_id_t;
+
+/**
+ * Profil de réglage d'un lot de cartes (table dans card_profiles.h)
+ */
+typedef struct {
+    uint8_t manufacturer_id;        // MID (0 = tout fabricant)
+    char oem_id[3];                 // OID, 2 caractères ("" = tout)
+    char product[6];                // PNM, 5 caractères ("" = tout)
+    uint32_t spi_freq_hz;           // Fréquence SPI de départ
+    uint16_t settle_ms;             // Stabilisation après mise sous tension
+    uint8_t batch_lines;            // Lignes par écriture du secteur de fin
+} card_profile_t;
+
+/**
+ * Registre SD Status (ACMD13) décodé
+ */
+typedef struct {
+    uint32_t au_sectors;            // Taille d'unité d'allocation (secteurs, 0 = inconnue)
+    uint16_t erase_size_au;         // AU effaçables en une opération (timeout ci-dessous)
+    uint8_t speed_class;            // Classe de vitesse (0, 2, 4, 6, 10)
+    uint8_t erase_timeout_s;        // Timeout d'effacement de erase_size_au AU
+    uint8_t erase_offset_s;         // Délai fixe ajouté à tout effacement
+    bool valid;
+} sd_card_status_t;
+
 // =============================================================================
 // MACROS UTILITAIRES
 // =============================================================================
@@ -0,0 +1,71 @@
+/**
+ * @file crash_ring.h
+ * @brief Anneau de diagnostic en RAM conservée à travers les resets logiciels
+ *
+ * Les derniers résultats de cycle, la fin de la trace SPI et la cause du
+ * reboot sont conservés dans une section RAM non initialisée (.noinit),
+ * validée par un magic et des CRC. Au boot suivant, l'anneau est affiché
+ * sur le port série puis ajouté au CSV sous forme de lignes "#CRASH".
+ *
+ * Coût par cycle: quelques écritures RAM, aucune écriture carte.
+ */
+
+#ifndef CRASH_RING_H
+#define CRASH_RING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Cause du reboot enregistrée avant system_reboot()
+ */
+typedef enum {
+    REBOOT_REASON_NONE = 0,         // Reset sans cause enregistrée (watchdog, bouton...)
+    REBOOT_REASON_MAX_FAILURES = 1,
+    REBOOT_REASON_CONTROLLER_INIT = 2,
+    REBOOT_REASON_INITIAL_MOUNT = 3
+} reboot_reason_t;
+
+/**
+ * @brief Valide l'anneau hérité du boot précédent
+ *
+ * À appeler tôt dans setup(). Un anneau invalide (mise sous tension,
+ * RAM corrompue) est réinitialisé.
+ *
+ * @return true si l'anneau contient un diagnostic du boot précédent
+ */
+bool crash_ring_init(void);
+
+/**
+ * @brief Enregistre le résultat d'un cycle et la fin de la trace SPI
+ *
+ * @param cycle Numéro du cycle
+ * @param result Résultat du cycle
+ */
+void crash_ring_record(uint32_t cycle, const cycle_result_t* result);
+
+/**
+ * @brief Enregistre la cause du prochain reboot
+ *
+ * @param reason Cause du reboot
+ */
+void crash_ring_set_reboot_reason(reboot_reason_t reason);
+
+/**
+ * @brief Affiche le diagnostic du boot précédent sur le port série
+ */
+void crash_ring_dump_serial(void);
+
+/**
+ * @brief Ajoute le diagnostic du boot précédent au CSV (carte montée)
+ *
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t crash_ring_dump_to_card(void);
+
+/**
+ * @brief Vide l'anneau une fois le diagnostic sauvegardé
+ */
+void crash_ring_clear(void);
+
+#endif // CRASH_RING_H
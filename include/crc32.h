@@ -0,0 +1,38 @@
+/**
+ * @file crc32.h
+ * @brief CRC-32 (IEEE 802.3) pour la validation des données persistées
+ *
+ * Implémentation par quartets (table de 16 entrées) pour limiter
+ * l'empreinte Flash sur l'ASR6501.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Valeur initiale pour un calcul incrémental
+ */
+#define CRC32_INIT  0xFFFFFFFFUL
+
+/**
+ * @brief Met à jour un CRC-32 en cours de calcul
+ *
+ * @param crc Valeur courante (CRC32_INIT au départ, sans inversion finale)
+ * @param data Données à ajouter
+ * @param len Nombre d'octets
+ * @return Nouvelle valeur courante
+ */
+uint32_t crc32_update(uint32_t crc, const void* data, uint32_t len);
+
+/**
+ * @brief Calcule le CRC-32 d'un bloc de données
+ *
+ * @param data Données
+ * @param len Nombre d'octets
+ * @return CRC-32 final
+ */
+uint32_t crc32_compute(const void* data, uint32_t len);
+
+#endif // CRC32_H
@@ -0,0 +1,60 @@
+/**
+ * @file endurance.h
+ * @brief Test d'endurance: usure d'une fenêtre fixe de secteurs
+ *
+ * Chaque cycle écrit puis relit ENDURANCE_PASSES_PER_CYCLE fois toute la
+ * fenêtre, en alternant deux motifs complémentaires. Une relecture fausse
+ * est réécrite une fois; si elle reste fausse, le secteur est déclaré usé
+ * et le test s'arrête. Le nombre d'écritures par secteur et l'attente de
+ * programmation mesurée donnent une durée de vie comparable d'un modèle de
+ * carte à l'autre.
+ *
+ * L'état (compteurs, secteur usé) et la courbe d'usure sont conservés dans
+ * ENDURANCE_LOG_FILE: le test reprend après un reboot.
+ */
+
+#ifndef ENDURANCE_H
+#define ENDURANCE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * État et mesures du test d'endurance
+ */
+typedef struct {
+    uint32_t passes;                            // Passes complètes sur la fenêtre
+    uint32_t writes[ENDURANCE_SECTORS];         // Écritures par secteur (réécritures incluses)
+    uint32_t rewrites;                          // Relectures fausses corrigées par réécriture
+    uint32_t records;                           // Points de la courbe d'usure
+    uint32_t first_avg_busy_us;                 // Attente moyenne du premier point
+    uint32_t last_avg_busy_us;                  // Attente moyenne du dernier point
+    uint32_t max_busy_us;                       // Pire attente depuis le début
+    bool worn;                                  // Erreur non corrigible atteinte
+    uint8_t worn_sector;                        // Index du secteur usé
+    uint32_t worn_pass;                         // Passe de l'erreur
+} endurance_stats_t;
+
+/**
+ * @brief Réinitialise l'état en RAM
+ *
+ * L'état persistant est relu au premier cycle (carte montée).
+ */
+void endurance_init(void);
+
+/**
+ * @brief Exécute les passes du cycle
+ *
+ * La carte doit être montée.
+ *
+ * @return ERR_NONE, ERR_SECTOR_WORN à la première erreur non corrigible
+ *         (et à chaque appel suivant), ou l'erreur d'accès à la carte
+ */
+sd_error_t endurance_run_cycle(void);
+
+/**
+ * @brief Accès à l'état et aux mesures
+ */
+const endurance_stats_t* endurance_get_stats(void);
+
+#endif // ENDURANCE_H
@@ -14,6 +14,12 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "workload.h"
+#include "verify.h"
+#include "bench.h"
+#include "endurance.h"
+#include "churn.h"
+#include "ram.h"
 
 // =============================================================================
 // DÉFINITIONS DES NIVEAUX DE LOG
@@ -112,6 +118,91 @@ void logger_print_cycle_result(uint32_t cycle, const cycle_result_t* result);
  */
 void logger_print_sd_info(const char* card_type, uint32_t size_mb);
 
+/**
+ * @brief Affiche l'identification de la carte (CID/CSD) et son profil
+ *
+ * @param id Identification lue au montage
+ * @param profile Profil retenu (nullptr = réglages par défaut)
+ */
+void logger_print_card_id(const sd_card_id_t* id, const card_profile_t* profile);
+
+/**
+ * @brief Affiche le registre SD Status (AU, classe de vitesse, effacement)
+ *
+ * @param status Pointeur vers le registre décodé
+ */
+void logger_print_card_status(const sd_card_status_t* status);
+
+/**
+ * @brief Affiche les métriques du système de fichiers (dernier montage)
+ *
+ * @param fs_stats Pointeur vers les métriques
+ */
+void logger_print_fs_stats(const sd_fs_stats_t* fs_stats);
+
+/**
+ * @brief Affiche débit et IOPS par combinaison taille x motif
+ *
+ * @param points Mesures du générateur de charge
+ * @param count Nombre de combinaisons
+ */
+void logger_print_workload(const workload_point_t* points, uint8_t count);
+
+/**
+ * @brief Affiche les résultats de la vérification par relecture
+ *
+ * @param stats Statistiques de vérification
+ */
+void logger_print_verify(const verify_stats_t* stats);
+
+/**
+ * @brief Affiche le tableau de synthèse du benchmark
+ *
+ * @param results Résultats par passe
+ * @param count Nombre de passes
+ */
+void logger_print_bench(const bench_result_t* results, uint8_t count);
+
+/**
+ * @brief Affiche l'état du test d'endurance
+ *
+ * @param stats État et mesures
+ */
+void logger_print_endurance(const endurance_stats_t* stats);
+
+/**
+ * @brief Affiche la carte de latence du journal et ses tranches lentes
+ *
+ * @param map Tranches écrites (sd_get_latency_map)
+ * @param count Nombre de tranches
+ * @param bucket_sectors Largeur d'une tranche en secteurs
+ * @param median_us Médiane des moyennes
+ */
+void logger_print_latency_map(const sd_latency_bucket_t* map, uint8_t count,
+                              uint32_t bucket_sectors, uint32_t median_us);
+
+/**
+ * @brief Affiche la latence par opération de métadonnées et par taille de
+ *        répertoire
+ *
+ * @param stats Statistiques de la charge de métadonnées
+ */
+void logger_print_churn(const churn_stats_t* stats);
+
+/**
+ * @brief Affiche l'occupation maximale de l'arena et de la pile
+ *
+ * @param stats Statistiques RAM
+ */
+void logger_print_ram(const ram_stats_t* stats);
+
+/**
+ * @brief Affiche la géométrie et la durée d'un formatage
+ *
+ * @param info Résultat de sd_format
+ */
+void logger_print_format(const sd_format_info_t* info);
+
 /**
  * @brief Affiche le banner de démarrage
  */
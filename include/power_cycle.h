@@ -59,6 +59,13 @@ uint32_t power_cycle(void);
  */
 bool power_is_on(void);
 
+/**
+ * @brief Règle le délai de stabilisation après mise sous tension
+ *
+ * @param settle_ms Délai en ms (0 = VEXT_POWER_ON_DELAY_MS)
+ */
+void power_set_settle_ms(uint16_t settle_ms);
+
 /**
  * @brief Obtient le délai total d'un power-cycle
  *
@@ -0,0 +1,70 @@
+/**
+ * @file ram.h
+ * @brief Arena de travail partagée et mesure de la pile
+ *
+ * Les tampons temporaires (secteur d'une charge de test, ligne CSV,
+ * message de log, rapport de benchmark, copie de la carte de latence)
+ * sont empruntés dans une arena de RAM_ARENA_BYTES octets le temps d'un
+ * appel: leur RAM statique n'est comptée qu'une fois et la pile ne les
+ * porte plus. Les baux sont rendus dans l'ordre inverse de leur prise,
+ * comme des variables locales.
+ */
+
+#ifndef RAM_H
+#define RAM_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Bail sur une zone de l'arena (à rendre avant la fin de la fonction)
+ */
+typedef struct {
+    uint16_t mark;              // Sommet de l'arena avant le bail
+} ram_lease_t;
+
+/**
+ * Occupation de l'arena et de la pile
+ */
+typedef struct {
+    uint16_t arena_size;
+    uint16_t arena_high_water;  // Plus forte occupation depuis le démarrage
+    uint16_t lease_failures;    // Baux refusés faute de place
+    uint32_t stack_painted;     // Octets peints sous la pile de setup() (0 = inactif)
+    uint32_t stack_high_water;  // Profondeur maximale atteinte dans cette zone
+} ram_stats_t;
+
+/**
+ * @brief Emprunte size octets dans l'arena
+ *
+ * @param lease Bail à rendre avec ram_release (même en cas d'échec)
+ * @param size Taille en octets
+ * @return Zone alignée sur 4 octets, nullptr si l'arena est pleine
+ */
+void* ram_lease(ram_lease_t* lease, uint16_t size);
+
+/**
+ * @brief Rend un bail, et les baux pris après lui
+ *
+ * @param lease Bail rendu par ram_lease
+ */
+void ram_release(const ram_lease_t* lease);
+
+/**
+ * @brief Peint la pile libre sous l'appelant (RAM_STACK_PAINT)
+ *
+ * À appeler une fois, en tête de setup(), avant tout appel profond.
+ */
+void ram_stack_paint(void);
+
+/**
+ * @brief Statistiques de l'arena et profondeur maximale de la pile
+ *
+ * La profondeur est obtenue en cherchant le motif encore intact: le
+ * parcours lit toute la zone peinte.
+ *
+ * @param out Statistiques
+ */
+void ram_get_stats(ram_stats_t* out);
+
+#endif // RAM_H
@@ -34,7 +34,7 @@ bool sd_controller_init(void);
  * Initialise la communication SPI avec la carte SD et monte le système FAT.
  * Gère automatiquement le fallback de fréquence SPI si activé.
  *
- * @param freq_hz Fréquence SPI souhaitée (0 = utiliser SD_SPI_FREQUENCY)
+ * @param freq_hz Fréquence SPI souhaitée (0 = profil de la carte ou SD_SPI_FREQUENCY)
  * @return sd_error_t Code d'erreur (ERR_NONE si succès)
  */
 sd_error_t sd_mount(uint32_t freq_hz = 0);
@@ -68,6 +68,67 @@ bool sd_is_mounted(void);
  */
 sd_error_t sd_write_csv_line(uint32_t cycle, const cycle_result_t* result, uint32_t timestamp_ms);
 
+/**
+ * @brief Relit le dernier enregistrement du log pour reprendre la numérotation
+ *
+ * Lit le secteur de fin retrouvé au montage (sans scan du fichier) et en
+ * extrait le numéro de cycle et l'époque de boot de la dernière ligne.
+ *
+ * @param last_cycle Numéro du dernier cycle enregistré
+ * @param last_epoch Époque de boot du dernier enregistrement
+ * @return true si un enregistrement a été trouvé
+ */
+bool sd_get_resume_point(uint32_t* last_cycle, uint32_t* last_epoch);
+
+/**
+ * @brief Ajoute une ligne de commentaire ('#' + texte) dans le fichier CSV
+ *
+ * Utilisé pour les événements de diagnostic (dump de l'anneau de crash).
+ * Les lecteurs CSV ignorent ces lignes (comment="#").
+ *
+ * @param text Texte sans '#' ni retour à la ligne
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t sd_write_log_comment(const char* text);
+
+/**
+ * @brief Copie la trace des dernières commandes SD envoyées
+ *
+ * @param out Tableau de destination, de la plus ancienne à la plus récente
+ * @param max Taille du tableau
+ * @return Nombre d'entrées copiées
+ */
+uint8_t sd_get_spi_trace(sd_trace_entry_t* out, uint8_t max);
+
+/**
+ * @brief Sauvegarde un bloc de données (statistiques) dans le checkpoint
+ *
+ * Écrit alternativement dans deux secteurs réservés du volume (A/B) avec
+ * un numéro de séquence et un CRC-32: une écriture interrompue laisse le
+ * checkpoint précédent intact.
+ *
+ * @param data Données à sauvegarder
+ * @param len Taille en octets (max 496)
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t sd_write_checkpoint(const void* data, uint16_t len);
+
+/**
+ * @brief Relit le checkpoint valide le plus récent
+ *
+ * @param data Buffer de destination (inchangé si aucun checkpoint valide)
+ * @param len Taille attendue en octets
+ * @return sd_error_t ERR_NONE si un checkpoint valide de cette taille existe
+ */
+sd_error_t sd_read_checkpoint(void* data, uint16_t len);
+
+/**
+ * @brief Définit l'époque de boot écrite dans la colonne boot_epoch du CSV
+ *
+ * @param epoch Numéro de boot (incrémenté à chaque redémarrage)
+ */
+void sd_set_boot_epoch(uint32_t epoch);
+
 /**
  * @brief Effectue un test de santé de la carte SD
  *
@@ -99,6 +160,26 @@ bool sd_reduce_frequency(void);
  */
 void sd_reset_frequency(void);
 
+/**
+ * @brief Impose la fréquence SPI des transferts (montage en cours inclus)
+ *
+ * @param freq_hz Fréquence en Hz
+ */
+void sd_set_frequency(uint32_t freq_hz);
+
+/**
+ * Nombre de fréquences de la table de repli (sd_get_frequency_table)
+ */
+#define SD_SPI_FREQ_COUNT   3
+
+/**
+ * @brief Accès à la table des fréquences de repli, décroissante
+ *
+ * @param table Reçoit la table
+ * @return Nombre de fréquences
+ */
+uint8_t sd_get_frequency_table(const uint32_t** table);
+
 /**
  * @brief Obtient des informations sur la carte SD
  *
@@ -118,4 +199,284 @@ uint32_t sd_get_last_init_time_us(void);
  */
 uint32_t sd_get_last_write_time_us(void);
 
+/**
+ * @brief Cumul des attentes de fin de programmation (microsecondes)
+ *
+ * Compteur libre (rebouclage ~71 min): n'utiliser que des différences.
+ */
+uint32_t sd_get_busy_time_us(void);
+
+/**
+ * @brief Plus longue attente de fin de programmation depuis sd_reset_busy_max
+ */
+uint32_t sd_get_busy_max_us(void);
+
+/**
+ * @brief Remet à zéro la plus longue attente de fin de programmation
+ */
+void sd_reset_busy_max(void);
+
+/**
+ * @brief Obtient les métriques du système de fichiers du dernier montage
+ *
+ * Inclut le coût de la récupération de fin de log (secteurs lus, durée).
+ *
+ * @param out Structure à remplir
+ */
+void sd_get_fs_stats(sd_fs_stats_t* out);
+
+/**
+ * @brief Carte de latence du journal (tranches écrites seulement)
+ *
+ * Attente de programmation par tranche de secteurs logiques du journal,
+ * depuis l'initialisation du contrôleur. Les tranches lentes signalent des
+ * blocs internes de la carte à surveiller.
+ *
+ * @param out Tableau de sortie
+ * @param max Taille du tableau (LATENCY_MAP_BUCKETS pour tout obtenir)
+ * @param bucket_sectors Reçoit la largeur d'une tranche en secteurs
+ * @param median_us Reçoit la médiane des moyennes
+ * @return Nombre de tranches écrites
+ */
+uint8_t sd_get_latency_map(sd_latency_bucket_t* out, uint8_t max,
+                           uint32_t* bucket_sectors, uint32_t* median_us);
+
+/**
+ * @brief Obtient le contenu du registre SD Status lu au montage (ACMD13)
+ *
+ * @param out Structure à remplir (taille d'AU, classe de vitesse, effacement)
+ * @return true si le registre a pu être lu
+ */
+bool sd_get_card_status(sd_card_status_t* out);
+
+/**
+ * @brief Obtient l'identification de la carte lue au montage (CID/CSD)
+ *
+ * @param out Structure à remplir (fabricant, série, capacité, timings)
+ * @return true si les registres ont pu être lus
+ */
+bool sd_get_card_id(sd_card_id_t* out);
+
+/**
+ * @brief Obtient le profil de réglage retenu pour la carte montée
+ *
+ * Le profil fixe la fréquence SPI de départ et la taille des lots
+ * d'écriture; le délai de stabilisation est appliqué par l'appelant.
+ *
+ * @return Profil de card_profiles.h, ou nullptr si aucun ne correspond
+ */
+const card_profile_t* sd_get_card_profile(void);
+
+/**
+ * @brief Lit un secteur brut de la carte
+ *
+ * @param sector Adresse LBA (secteurs de 512 octets)
+ * @param buffer Tampon de 512 octets
+ * @return true si succès
+ */
+bool sd_read_sector(uint32_t sector, uint8_t* buffer);
+
+/**
+ * @brief Écrit un secteur brut de la carte
+ *
+ * Aucune protection du système de fichiers: n'adresser que le fichier
+ * de travail (sd_scratch_open).
+ *
+ * @param sector Adresse LBA (secteurs de 512 octets)
+ * @param buffer Tampon de 512 octets
+ * @return true si succès
+ */
+bool sd_write_sector(uint32_t sector, const uint8_t* buffer);
+
+/**
+ * @brief Écriture multi-secteurs (CMD25): début, un appel par secteur, fin
+ *
+ * En cas d'échec de sd_write_multi_next, le flux est clos (STOP_TRAN) et
+ * la carte désélectionnée: sd_write_multi_end ne doit pas être appelé.
+ */
+bool sd_write_multi_begin(uint32_t sector);
+bool sd_write_multi_next(const uint8_t* buffer);
+bool sd_write_multi_end(void);
+
+/**
+ * @brief Lecture multi-secteurs (CMD18): début, un appel par secteur, fin
+ *
+ * Mêmes règles qu'en écriture (flux clos par CMD12 en cas d'échec).
+ */
+bool sd_read_multi_begin(uint32_t sector);
+bool sd_read_multi_next(uint8_t* buffer);
+bool sd_read_multi_end(void);
+
+/**
+ * @brief Formate la carte: MBR et volume FAT32 alignés, journal préalloué
+ *
+ * Efface toute donnée de la carte. Partition et zone de données commencent
+ * sur une frontière d'AU; FSInfo est initialisé et le fichier journal créé
+ * avec FORMAT_LOG_PREALLOC_SECTORS secteurs de chaîne contiguë. La carte
+ * reste démontée: appeler sd_mount() ensuite.
+ *
+ * @param info Reçoit la géométrie écrite et la durée
+ * @return ERR_NONE, ERR_FAT_VOLUME_FAILED si la carte est trop petite pour
+ *         FAT32, ERR_FILE_WRITE_FAILED en cas d'échec d'écriture
+ */
+sd_error_t sd_format(sd_format_info_t* info);
+
+/**
+ * @brief Efface des secteurs bruts (CMD32/CMD33/CMD38)
+ *
+ * Découpe alignée sur les AU; durée et volume comptés dans les métriques
+ * du système de fichiers. Le contenu lu ensuite vaut 0x00 ou 0xFF selon la
+ * carte. Mêmes restrictions d'adresse que sd_write_sector.
+ *
+ * @param sector Premier secteur (LBA)
+ * @param count Nombre de secteurs
+ * @return ERR_NONE, ERR_FILE_WRITE_FAILED si la carte refuse ou dépasse le délai
+ */
+sd_error_t sd_erase_sectors(uint32_t sector, uint32_t count);
+
+/**
+ * @brief Ouvre (ou crée) le fichier de travail contigu SCRATCH.BIN
+ *
+ * Réservé aux charges de test qui écrivent des secteurs bruts: tout le
+ * fichier est alloué d'un bloc, à partir d'une frontière d'AU si possible.
+ * Un fichier existant trop petit ou fragmenté est réalloué.
+ *
+ * @param sectors Taille minimale en secteurs
+ * @param first_sector LBA du premier secteur du fichier
+ * @return ERR_NONE, ERR_VOLUME_FULL si aucune zone libre contiguë
+ */
+sd_error_t sd_scratch_open(uint32_t sectors, uint32_t* first_sector);
+
+/**
+ * @brief Ouvre (ou crée) un fichier contigu à la racine
+ *
+ * Comme sd_scratch_open, sans cache de l'emplacement: une recherche dans
+ * le répertoire par appel. Le contenu d'un fichier créé ou réalloué est
+ * indéterminé.
+ *
+ * @param name83 Nom au format 8.3 du répertoire
+ * @param sectors Taille minimale en secteurs
+ * @param first_sector LBA du premier secteur du fichier
+ * @return ERR_NONE, ERR_VOLUME_FULL si aucune zone libre contiguë
+ */
+sd_error_t sd_contig_file_open(const char* name83, uint32_t sectors, uint32_t* first_sector);
+
+/**
+ * @brief Écrit (remplace) un petit fichier texte contigu à la racine
+ *
+ * Pour les rapports de résultats: tout le contenu est fourni d'un bloc.
+ *
+ * @param name83 Nom au format 8.3 du répertoire ("BENCH   CSV")
+ * @param text Contenu
+ * @param len Taille en octets
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t sd_write_text_file(const char* name83, const char* text, uint32_t len);
+
+/**
+ * @brief Ouvre (ou crée) un fichier texte annexe en ajout, à la racine
+ *
+ * Table de FILE_HANDLE_COUNT handles: chacun garde sa position de fin,
+ * sa dernière suite de clusters et sa taille commise, et reste valable
+ * d'un montage à l'autre (entrée revérifiée par une lecture au premier
+ * accès). Le secteur de fin en RAM est partagé avec le journal CSV.
+ * Ouvrir un fichier déjà ouvert rend le même handle.
+ *
+ * @param name83 Nom au format 8.3 du répertoire ("EVENTS  TXT")
+ * @param file Handle du fichier
+ * @return ERR_NONE, ERR_BUFFER_OVERFLOW si la table est pleine
+ */
+sd_error_t sd_file_open(const char* name83, int8_t* file);
+
+/**
+ * @brief Ajoute du texte en fin de fichier annexe
+ *
+ * Les données restent en RAM jusqu'à ce que le secteur soit plein, que le
+ * journal ou un autre fichier reprenne le secteur de fin, ou jusqu'au
+ * commit (sd_file_sync, sd_unmount).
+ *
+ * @param file Handle rendu par sd_file_open
+ * @param text Texte à ajouter
+ * @param len Taille en octets
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t sd_file_append(int8_t file, const char* text, uint16_t len);
+
+/**
+ * @brief Commit d'un fichier annexe: secteur de fin, FAT, taille
+ *
+ * @param file Handle rendu par sd_file_open
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t sd_file_sync(int8_t file);
+
+/**
+ * @brief Commit puis libère le handle (libéré même en cas d'erreur)
+ *
+ * @param file Handle rendu par sd_file_open
+ * @return sd_error_t Code d'erreur du commit
+ */
+sd_error_t sd_file_close(int8_t file);
+
+/**
+ * @brief Taille d'un fichier annexe ouvert, données en RAM comprises
+ *
+ * @param file Handle rendu par sd_file_open
+ * @return Taille en octets (0 si handle invalide)
+ */
+uint32_t sd_file_size(int8_t file);
+
+/**
+ * @brief Ouvre (ou crée) le sous-répertoire des opérations sd_meta_*
+ *
+ * Charge de test des métadonnées: les opérations suivantes portent sur les
+ * fichiers de ce répertoire. L'emplacement est conservé jusqu'à
+ * sd_controller_init.
+ *
+ * @param name83 Nom au format 8.3 du répertoire, à la racine
+ * @return sd_error_t Code d'erreur (ERR_NONE si succès)
+ */
+sd_error_t sd_meta_dir_open(const char* name83);
+
+/**
+ * @brief Indique si le répertoire des opérations sd_meta_* est ouvert
+ *
+ * Faux après un changement de carte: le volume est relu et le répertoire
+ * doit être rouvert.
+ */
+bool sd_meta_dir_is_open(void);
+
+/**
+ * @brief Crée un fichier vide
+ *
+ * Les opérations sd_meta_* ajoutent leur temps à t et renvoient
+ * ERR_FILE_EXISTS si le fichier existe (création, destination d'un
+ * renommage), ERR_FILE_OPEN_FAILED s'il n'existe pas (autres, source d'un
+ * renommage), ERR_FILE_READ_FAILED si le répertoire n'a pas pu être lu.
+ *
+ * @param name83 Nom au format 8.3
+ * @param t Temps cumulés par étape
+ */
+sd_error_t sd_meta_create(const char* name83, sd_meta_timing_t* t);
+
+/**
+ * @brief Ajoute bytes octets en fin de fichier (clusters alloués au besoin)
+ */
+sd_error_t sd_meta_append(const char* name83, uint32_t bytes, sd_meta_timing_t* t);
+
+/**
+ * @brief Tronque un fichier à zéro octet et libère sa chaîne
+ */
+sd_error_t sd_meta_truncate(const char* name83, sd_meta_timing_t* t);
+
+/**
+ * @brief Renomme un fichier dans le même répertoire
+ */
+sd_error_t sd_meta_rename(const char* from83, const char* to83, sd_meta_timing_t* t);
+
+/**
+ * @brief Supprime un fichier et libère sa chaîne
+ */
+sd_error_t sd_meta_delete(const char* name83, sd_meta_timing_t* t);
+
 #endif // SD_CONTROLLER_H
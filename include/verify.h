@@ -0,0 +1,71 @@
+/**
+ * @file verify.h
+ * @brief Vérification par relecture des données écrites sur la carte
+ *
+ * Chaque cycle écrit un secteur de contrôle dans un anneau de SCRATCH.BIN:
+ * en-tête (magic, séquence, graine), charge pseudo-aléatoire dérivée de la
+ * séquence et CRC-32. Les K derniers secteurs sont ensuite relus et
+ * comparés octet par octet au contenu attendu, régénéré sans tampon.
+ *
+ * Les erreurs sont comptées par position de bit, par ancienneté du secteur
+ * et par fréquence SPI d'écriture: c'est le taux de corruption en fonction
+ * de l'horloge qui fixe la fréquence de production.
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Corruption observée pour une fréquence d'écriture
+ */
+typedef struct {
+    uint32_t freq_hz;
+    uint32_t sectors_read;
+    uint32_t sectors_bad;
+    uint32_t bit_errors;
+} verify_freq_point_t;
+
+/**
+ * Statistiques de vérification
+ */
+typedef struct {
+    uint32_t sectors_written;
+    uint32_t sectors_read;
+    uint32_t sectors_bad;                       // Au moins un bit différent
+    uint32_t crc_failures;                      // Détectées par le seul CRC
+    uint32_t bit_errors[8];                     // Par position dans l'octet
+    uint32_t age_errors[VERIFY_READBACK_SECTORS];  // Par ancienneté (0 = ce cycle)
+    uint32_t last_bad_lba;
+    uint64_t write_bytes;
+    uint64_t write_time_us;
+    uint64_t read_bytes;
+    uint64_t read_time_us;
+    verify_freq_point_t freq[VERIFY_FREQ_SLOTS];
+} verify_stats_t;
+
+/**
+ * @brief Réinitialise l'anneau et les statistiques
+ *
+ * Les secteurs d'une session précédente ne sont pas relus.
+ */
+void verify_init(void);
+
+/**
+ * @brief Écrit le secteur de contrôle du cycle puis relit les K derniers
+ *
+ * La carte doit être montée.
+ *
+ * @return ERR_NONE (même en cas de corruption, comptée dans les
+ *         statistiques), ou l'erreur d'accès à la carte
+ */
+sd_error_t verify_run_cycle(void);
+
+/**
+ * @brief Accès aux statistiques
+ */
+const verify_stats_t* verify_get_stats(void);
+
+#endif // VERIFY_H
@@ -0,0 +1,68 @@
+/**
+ * @file workload.h
+ * @brief Générateur de charge d'E/S dans le fichier de travail SCRATCH.BIN
+ *
+ * En plus de la ligne CSV du cycle, chaque cycle exécute une série
+ * d'opérations d'une taille (1 o à 64 Ko) et d'un motif (séquentiel ou
+ * aléatoire) donnés, avec une proportion de lectures configurable. Les
+ * combinaisons taille x motif sont parcourues à tour de rôle: on obtient
+ * une courbe débit/IOPS en fonction de la taille, par motif.
+ *
+ * Les écritures partielles de secteur passent par une lecture-modification-
+ * écriture, comme dans un système de fichiers. La carte doit être montée.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Motif d'adressage dans le fichier de travail
+ */
+typedef enum {
+    WORKLOAD_SEQUENTIAL = 0,
+    WORKLOAD_RANDOM = 1,
+    WORKLOAD_PATTERN_COUNT
+} workload_pattern_t;
+
+/**
+ * Mesures cumulées d'une combinaison taille x motif
+ */
+typedef struct {
+    uint32_t size;                  // Octets par opération
+    uint8_t pattern;                // workload_pattern_t
+    uint32_t write_ops;
+    uint32_t read_ops;
+    uint64_t write_bytes;
+    uint64_t read_bytes;
+    uint64_t write_time_us;
+    uint64_t read_time_us;
+    uint32_t errors;
+} workload_point_t;
+
+/**
+ * @brief Réinitialise les mesures et le générateur pseudo-aléatoire
+ */
+void workload_init(void);
+
+/**
+ * @brief Exécute les opérations du cycle sur la combinaison suivante
+ *
+ * Ouvre (ou crée au premier appel) le fichier de travail.
+ *
+ * @param cycle Numéro du cycle (choix de la combinaison)
+ * @return ERR_NONE, ou l'erreur de la première opération échouée
+ */
+sd_error_t workload_run_cycle(uint32_t cycle);
+
+/**
+ * @brief Accès aux mesures par combinaison
+ *
+ * @param points Reçoit le tableau des mesures
+ * @return Nombre de combinaisons
+ */
+uint8_t workload_get_points(const workload_point_t** points);
+
+#endif // WORKLOAD_H
@@ -0,0 +1,69 @@
+"""
+Rapport de budget RAM après l'édition de liens (PlatformIO, post-script)
+
+Affiche la RAM statique par section (.data, .bss, .noinit), les plus gros
+symboles et ce qui reste pour la pile et le tas. L'édition échoue si ce
+reste passe sous custom_ram_stack_min (octets, platformio.ini).
+"""
+
+import subprocess
+
+Import("env")
+
+RAM_SECTIONS = (".data", ".bss", ".noinit")
+TOP_SYMBOLS = 12
+
+
+def tool(name):
+    # arm-none-eabi-gcc -> arm-none-eabi-size / arm-none-eabi-nm
+    cc = env.subst("$CC")
+    return cc[: -len("gcc")] + name if cc.endswith("gcc") else name
+
+
+def section_sizes(elf):
+    out = subprocess.check_output([tool("size"), "-A", elf], text=True)
+    sizes = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in RAM_SECTIONS:
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def largest_symbols(elf):
+    out = subprocess.check_output([tool("nm"), "-S", "-C", "--size-sort", "-r", elf], text=True)
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "bBdD":
+            symbols.append((int(fields[1], 16), fields[3]))
+        if len(symbols) >= TOP_SYMBOLS:
+            break
+    return symbols
+
+
+def ram_report(source, target, env):
+    elf = str(target[0])
+    ram_size = int(env.BoardConfig().get("upload.maximum_ram_size", 16384))
+    stack_min = int(env.GetProjectOption("custom_ram_stack_min", "2048"))
+
+    sizes = section_sizes(elf)
+    static = sum(sizes.values())
+    free = ram_size - static
+
+    print("RAM budget: %d bytes" % ram_size)
+    for name in RAM_SECTIONS:
+        if name in sizes:
+            print("  %-8s %6d" % (name, sizes[name]))
+    print("  static   %6d (%d%%)" % (static, static * 100 // ram_size))
+    print("  stack+heap %4d (minimum %d)" % (free, stack_min))
+    print("Largest RAM symbols:")
+    for size, name in largest_symbols(elf):
+        print("  %6d  %s" % (size, name))
+
+    if free < stack_min:
+        print("Error: %d bytes left for stack and heap, %d required" % (free, stack_min))
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", ram_report)
@@ -0,0 +1,260 @@
+/**
+ * @file bench.cpp
+ * @brief Implémentation du benchmark de débit séquentiel et d'IOPS aléatoires
+ */
+
+#include "bench.h"
+#include "sd_controller.h"
+#include "ram.h"
+
+// =============================================================================
+// CONSTANTES
+// =============================================================================
+
+// Passes par fréquence: écriture/lecture x secteur unique/multi-bloc
+#define BENCH_PASSES_PER_FREQ   4
+#define BENCH_RANDOM_PASSES     2
+#define BENCH_MAX_RESULTS       (SD_SPI_FREQ_COUNT * BENCH_PASSES_PER_FREQ + BENCH_RANDOM_PASSES)
+
+// Histogramme log2 à 4 sous-classes: ~20 % de résolution jusqu'à 2^17 µs
+#define LAT_HIST_BUCKETS        64
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+static bench_result_t results[BENCH_MAX_RESULTS];
+static uint8_t result_count = 0;
+static uint16_t lat_hist[LAT_HIST_BUCKETS];
+static uint16_t random_hist[2][LAT_HIST_BUCKETS];  // [lecture, écriture]
+static uint32_t rng_state = BENCH_RANDOM_SEED;
+static uint8_t* io_buffer = nullptr;    // Empruntés à l'arena pendant bench_run
+static char* report = nullptr;
+
+// =============================================================================
+// HISTOGRAMME DE LATENCE
+// =============================================================================
+
+static uint8_t lat_bucket(uint32_t us) {
+    if (us < 4) {
+        return us;
+    }
+
+    uint8_t log2 = 31 - __builtin_clz(us);
+    uint8_t bucket = 4 * (log2 - 1) + ((us >> (log2 - 2)) & 3);
+    return (bucket < LAT_HIST_BUCKETS) ? bucket : LAT_HIST_BUCKETS - 1;
+}
+
+uint32_t bench_hist_floor(uint8_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    uint8_t log2 = bucket / 4 + 1;
+    return (4UL | (bucket % 4)) << (log2 - 2);
+}
+
+static uint32_t lat_percentile(uint32_t total, uint16_t permille) {
+    uint32_t rank = ((uint64_t)total * permille + 999) / 1000;
+    uint32_t seen = 0;
+
+    for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++) {
+        seen += lat_hist[i];
+        if (seen >= rank && seen > 0) {
+            return bench_hist_floor(i);
+        }
+    }
+    return 0;
+}
+
+// =============================================================================
+// PASSES
+// =============================================================================
+
+// xorshift32: même séquence d'adresses à chaque passe pour une graine donnée
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static bool transfer_one(bench_mode_t mode, bool is_write, uint32_t lba) {
+    if (mode == BENCH_MULTI) {
+        return is_write ? sd_write_multi_next(io_buffer) : sd_read_multi_next(io_buffer);
+    }
+    return is_write ? sd_write_sector(lba, io_buffer) : sd_read_sector(lba, io_buffer);
+}
+
+static void run_pass(uint32_t base, uint32_t sectors, bench_mode_t mode, bool is_write,
+                     bench_result_t* r) {
+    memset(lat_hist, 0, sizeof(lat_hist));
+    memset(r, 0, sizeof(*r));
+    r->freq_hz = sd_get_current_frequency();
+    r->mode = mode;
+    r->is_write = is_write;
+
+    uint32_t window = (BENCH_RANDOM_WINDOW_SECTORS < WORKLOAD_SCRATCH_SECTORS) ?
+                      BENCH_RANDOM_WINDOW_SECTORS : WORKLOAD_SCRATCH_SECTORS;
+    rng_state = BENCH_RANDOM_SEED ? BENCH_RANDOM_SEED : 1;
+
+    // Zone effacée: chaque passe d'écriture part du même état de la carte
+    if (ERASE_ENABLED && is_write) {
+        uint32_t erase_start = micros();
+        if (sd_erase_sectors(base, (mode == BENCH_RANDOM) ? window : sectors) != ERR_NONE) {
+            r->errors++;
+        }
+        r->erase_us = micros() - erase_start;
+    }
+
+    sd_reset_busy_max();
+    uint32_t busy_start = sd_get_busy_time_us();
+    uint32_t start = micros();
+    bool open = true;
+
+    if (mode == BENCH_MULTI) {
+        open = is_write ? sd_write_multi_begin(base) : sd_read_multi_begin(base);
+    }
+
+    for (uint32_t i = 0; open && i < sectors; i++) {
+        if (is_write) {
+            io_buffer[0] = (uint8_t)i;
+        }
+
+        uint32_t lba = base + ((mode == BENCH_RANDOM) ? rng_next() % window : i);
+        uint32_t op_start = micros();
+        bool ok = transfer_one(mode, is_write, lba);
+        uint32_t elapsed = micros() - op_start;
+
+        if (!ok) {
+            // Un flux interrompu est abandonné par la couche SD
+            r->errors++;
+            open = (mode == BENCH_SINGLE);
+            continue;
+        }
+
+        r->sectors++;
+        if (elapsed > r->max_us) {
+            r->max_us = elapsed;
+        }
+        uint8_t bucket = lat_bucket(elapsed);
+        if (lat_hist[bucket] < 0xFFFF) {
+            lat_hist[bucket]++;
+        }
+    }
+
+    if (mode == BENCH_MULTI && open) {
+        bool ok = is_write ? sd_write_multi_end() : sd_read_multi_end();
+        if (!ok) {
+            r->errors++;
+        }
+    }
+
+    r->time_us = micros() - start;
+    r->busy_us = sd_get_busy_time_us() - busy_start;
+    r->p50_us = lat_percentile(r->sectors, 500);
+    r->p90_us = lat_percentile(r->sectors, 900);
+    r->p99_us = lat_percentile(r->sectors, 990);
+    r->p999_us = lat_percentile(r->sectors, 999);
+    r->busy_max_us = sd_get_busy_max_us();
+
+    if (mode == BENCH_RANDOM) {
+        memcpy(random_hist[is_write], lat_hist, sizeof(lat_hist));
+    }
+}
+
+const char* bench_mode_name(uint8_t mode) {
+    switch (mode) {
+        case BENCH_MULTI:  return "multi";
+        case BENCH_RANDOM: return "random";
+        default:           return "single";
+    }
+}
+
+// Une ligne CSV par passe
+static uint16_t format_report(void) {
+    int len = snprintf(report, BENCH_REPORT_BYTES,
+                       "freq_hz,mode,dir,sectors,kb_per_s,iops,p50_us,p90_us,p99_us,p999_us,max_us,busy_pct,busy_max_us,erase_us,errors\n");
+
+    for (uint8_t i = 0; i < result_count && len < BENCH_REPORT_BYTES; i++) {
+        const bench_result_t* r = &results[i];
+        uint32_t kbps = r->time_us ? (uint32_t)((uint64_t)r->sectors * 512 * 1000000ULL / 1024 / r->time_us) : 0;
+        uint32_t iops = r->time_us ? (uint32_t)((uint64_t)r->sectors * 1000000ULL / r->time_us) : 0;
+        uint32_t busy_pct = r->time_us ? (uint32_t)((uint64_t)r->busy_us * 100 / r->time_us) : 0;
+
+        len += snprintf(&report[len], BENCH_REPORT_BYTES - len,
+                        "%lu,%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                        (unsigned long)r->freq_hz, bench_mode_name(r->mode),
+                        r->is_write ? "write" : "read",
+                        (unsigned long)r->sectors, (unsigned long)kbps, (unsigned long)iops,
+                        (unsigned long)r->p50_us, (unsigned long)r->p90_us,
+                        (unsigned long)r->p99_us, (unsigned long)r->p999_us,
+                        (unsigned long)r->max_us, (unsigned long)busy_pct,
+                        (unsigned long)r->busy_max_us, (unsigned long)r->erase_us,
+                        (unsigned long)r->errors);
+    }
+
+    return (len < BENCH_REPORT_BYTES) ? len : BENCH_REPORT_BYTES - 1;
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+sd_error_t bench_run(void) {
+    uint32_t base;
+    sd_error_t err = sd_scratch_open(SCRATCH_FILE_SECTORS, &base);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    uint32_t sectors = (BENCH_SEQ_SECTORS < WORKLOAD_SCRATCH_SECTORS) ? BENCH_SEQ_SECTORS : WORKLOAD_SCRATCH_SECTORS;
+    const uint32_t* freqs;
+    uint8_t freq_count = sd_get_frequency_table(&freqs);
+
+    // Secteur des passes puis rapport, empruntés l'un après l'autre
+    ram_lease_t lease;
+    io_buffer = (uint8_t*)ram_lease(&lease, 512);
+    if (io_buffer == nullptr) {
+        ram_release(&lease);
+        return ERR_BUFFER_OVERFLOW;
+    }
+
+    uint32_t saved_freq = sd_get_current_frequency();
+    memset(io_buffer, 0xA5, 512);
+    result_count = 0;
+
+    for (uint8_t f = 0; f < freq_count; f++) {
+        sd_set_frequency(freqs[f]);
+        run_pass(base, sectors, BENCH_SINGLE, true, &results[result_count++]);
+        run_pass(base, sectors, BENCH_SINGLE, false, &results[result_count++]);
+        run_pass(base, sectors, BENCH_MULTI, true, &results[result_count++]);
+        run_pass(base, sectors, BENCH_MULTI, false, &results[result_count++]);
+    }
+
+    sd_set_frequency(saved_freq);
+
+    // Aléatoire à la fréquence de production; écriture d'abord pour relire
+    // des secteurs écrits
+    uint32_t random_ops = BENCH_RANDOM_OPS;
+    run_pass(base, random_ops, BENCH_RANDOM, true, &results[result_count++]);
+    run_pass(base, random_ops, BENCH_RANDOM, false, &results[result_count++]);
+    ram_release(&lease);
+    io_buffer = nullptr;
+
+    report = (char*)ram_lease(&lease, BENCH_REPORT_BYTES);
+    err = (report != nullptr) ?
+          sd_write_text_file(BENCH_RESULTS_FILE, report, format_report()) : ERR_BUFFER_OVERFLOW;
+    ram_release(&lease);
+    report = nullptr;
+    return err;
+}
+
+uint8_t bench_get_results(const bench_result_t** out) {
+    *out = results;
+    return result_count;
+}
+
+uint8_t bench_get_random_hist(bool is_write, const uint16_t** hist) {
+    *hist = random_hist[is_write];
+    return LAT_HIST_BUCKETS;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file churn.cpp
+ * @brief Implémentation de la charge de test des métadonnées
+ */
+
+#include "churn.h"
+#include "sd_controller.h"
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+static churn_stats_t stats;
+static uint8_t present[(CHURN_MAX_FILES + 7) / 8];  // Fichiers existants (bit par nom)
+static uint32_t rng_state = 1;
+
+// =============================================================================
+// FONCTIONS INTERNES
+// =============================================================================
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// "CH000042DAT" pour l'index 42
+static void file_name(uint16_t index, char* name) {
+    snprintf(name, 12, "CH%06uDAT", index);
+}
+
+static bool is_present(uint16_t index) {
+    return (present[index / 8] >> (index % 8)) & 1;
+}
+
+static void set_present(uint16_t index, bool value) {
+    if (value == is_present(index)) {
+        return;
+    }
+    if (value) {
+        present[index / 8] |= (1 << (index % 8));
+        stats.files++;
+    } else {
+        present[index / 8] &= ~(1 << (index % 8));
+        stats.files--;
+    }
+}
+
+// Nom absent pour la destination d'un renommage (CHURN_MAX_FILES si aucun)
+static uint16_t pick_absent(void) {
+    uint16_t start = rng_next() % CHURN_MAX_FILES;
+    for (uint16_t i = 0; i < CHURN_MAX_FILES; i++) {
+        uint16_t index = (start + i) % CHURN_MAX_FILES;
+        if (!is_present(index)) {
+            return index;
+        }
+    }
+    return CHURN_MAX_FILES;
+}
+
+static void record(churn_op_t op, const sd_meta_timing_t* t, uint32_t total_us) {
+    churn_op_stats_t* s = &stats.ops[op];
+    s->count++;
+    s->scan_us += t->scan_us;
+    s->entry_us += t->entry_us;
+    s->fat_us += t->fat_us;
+    s->data_us += t->data_us;
+    if (total_us > s->max_us) {
+        s->max_us = total_us;
+    }
+
+    // Parcours rapporté à la taille du répertoire lu par recherche
+    uint32_t lookups = (op == CHURN_RENAME) ? 2 : 1;
+    uint32_t sectors = t->dir_sectors / lookups;
+    uint8_t size_class = 0;
+    while (sectors > 1 && size_class < CHURN_SIZE_CLASSES - 1) {
+        sectors >>= 1;
+        size_class++;
+    }
+    stats.sizes[size_class].ops += lookups;
+    stats.sizes[size_class].scan_us += t->scan_us;
+
+    if (t->dir_sectors / lookups > stats.max_dir_sectors) {
+        stats.max_dir_sectors = t->dir_sectors / lookups;
+    }
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+void churn_init(void) {
+    memset(&stats, 0, sizeof(stats));
+    memset(present, 0, sizeof(present));
+    rng_state = micros() | 1;
+}
+
+sd_error_t churn_run_cycle(void) {
+    // Rouvert à chaque changement de carte
+    if (!sd_meta_dir_is_open()) {
+        sd_error_t err = sd_meta_dir_open(CHURN_DIR_NAME);
+        if (err != ERR_NONE) {
+            return err;
+        }
+    }
+
+    for (uint8_t n = 0; n < CHURN_OPS_PER_CYCLE; n++) {
+        uint16_t index = rng_next() % CHURN_MAX_FILES;
+        char name[12], target[12];
+        file_name(index, name);
+
+        churn_op_t op = CHURN_CREATE;
+        uint16_t to_index = CHURN_MAX_FILES;
+        if (is_present(index)) {
+            // 40 % complément, 15 % troncature, 15 % renommage, 30 % suppression
+            uint8_t roll = rng_next() % 100;
+            op = (roll < 40) ? CHURN_APPEND : (roll < 55) ? CHURN_TRUNCATE :
+                 (roll < 70) ? CHURN_RENAME : CHURN_DELETE;
+            if (op == CHURN_RENAME) {
+                to_index = pick_absent();
+                if (to_index == CHURN_MAX_FILES) {
+                    op = CHURN_APPEND;
+                } else {
+                    file_name(to_index, target);
+                }
+            }
+        }
+
+        sd_meta_timing_t t;
+        memset(&t, 0, sizeof(t));
+        uint32_t start = micros();
+        sd_error_t err;
+
+        switch (op) {
+            case CHURN_CREATE:   err = sd_meta_create(name, &t); break;
+            case CHURN_APPEND:   err = sd_meta_append(name, CHURN_APPEND_BYTES, &t); break;
+            case CHURN_TRUNCATE: err = sd_meta_truncate(name, &t); break;
+            case CHURN_RENAME:   err = sd_meta_rename(name, target, &t); break;
+            default:             err = sd_meta_delete(name, &t); break;
+        }
+        uint32_t elapsed = micros() - start;
+
+        // État inconnu après un reboot: le répertoire fait foi
+        if (err == ERR_FILE_EXISTS) {
+            set_present((op == CHURN_RENAME) ? to_index : index, true);
+            continue;
+        }
+        if (err == ERR_FILE_OPEN_FAILED) {
+            set_present(index, false);
+            continue;
+        }
+        if (err != ERR_NONE) {
+            stats.ops[op].errors++;
+            return err;
+        }
+
+        record(op, &t, elapsed);
+        if (op == CHURN_CREATE) {
+            set_present(index, true);
+        } else if (op == CHURN_DELETE) {
+            set_present(index, false);
+        } else if (op == CHURN_RENAME) {
+            set_present(index, false);
+            set_present(to_index, true);
+        }
+    }
+
+    return ERR_NONE;
+}
+
+const churn_stats_t* churn_get_stats(void) {
+    return &stats;
+}
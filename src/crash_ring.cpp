@@ -0,0 +1,222 @@
+/**
+ * @file crash_ring.cpp
+ * @brief Implémentation de l'anneau de diagnostic en RAM conservée
+ */
+
+#include "crash_ring.h"
+#include "crc32.h"
+#include "logger.h"
+#include "sd_controller.h"
+#include "ram.h"
+#include <stddef.h>
+
+// =============================================================================
+// CONSTANTES
+// =============================================================================
+
+#define CRASH_RING_MAGIC    0x48535243UL    // "CRSH"
+
+// Causes de reboot
+static const char REASON_STR_NONE[] PROGMEM = "UNKNOWN";
+static const char REASON_STR_MAX_FAILURES[] PROGMEM = "MAX_FAILURES";
+static const char REASON_STR_CONTROLLER_INIT[] PROGMEM = "CONTROLLER_INIT";
+static const char REASON_STR_INITIAL_MOUNT[] PROGMEM = "INITIAL_MOUNT";
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+typedef struct {
+    uint32_t cycle;
+    uint32_t timestamp_ms;
+    cycle_result_t result;
+    uint32_t crc;
+} crash_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t head;               // Prochaine entrée à écrire
+    uint8_t count;
+    uint8_t reboot_reason;
+    uint8_t trace_count;
+    sd_trace_entry_t trace[SD_TRACE_DEPTH];
+    uint32_t crc;               // CRC des champs ci-dessus
+    crash_entry_t entries[CRASH_RING_ENTRIES];
+} crash_ring_t;
+
+// Non initialisé au démarrage: conserve le contenu à travers HW_Reset()
+static crash_ring_t ring __attribute__((section(CRASH_RING_SECTION)));
+
+// =============================================================================
+// FONCTIONS PRIVÉES
+// =============================================================================
+
+static uint32_t header_crc(void) {
+    return crc32_compute(&ring, offsetof(crash_ring_t, crc));
+}
+
+static uint32_t entry_crc(const crash_entry_t* entry) {
+    return crc32_compute(entry, offsetof(crash_entry_t, crc));
+}
+
+static void seal_header(void) {
+    ring.crc = header_crc();
+}
+
+static const __FlashStringHelper* reason_to_string(uint8_t reason) {
+    switch (reason) {
+        case REBOOT_REASON_MAX_FAILURES:
+            return (__FlashStringHelper*)REASON_STR_MAX_FAILURES;
+        case REBOOT_REASON_CONTROLLER_INIT:
+            return (__FlashStringHelper*)REASON_STR_CONTROLLER_INIT;
+        case REBOOT_REASON_INITIAL_MOUNT:
+            return (__FlashStringHelper*)REASON_STR_INITIAL_MOUNT;
+        default:
+            return (__FlashStringHelper*)REASON_STR_NONE;
+    }
+}
+
+/**
+ * @brief Retourne la i-ème entrée valide, de la plus ancienne à la plus récente
+ */
+static const crash_entry_t* ring_entry(uint8_t i) {
+    uint8_t index = (ring.head + CRASH_RING_ENTRIES - ring.count + i) % CRASH_RING_ENTRIES;
+    const crash_entry_t* entry = &ring.entries[index];
+    return (entry->crc == entry_crc(entry)) ? entry : nullptr;
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+bool crash_ring_init(void) {
+    if (ring.magic == CRASH_RING_MAGIC && ring.crc == header_crc() &&
+        ring.head < CRASH_RING_ENTRIES && ring.count <= CRASH_RING_ENTRIES &&
+        ring.trace_count <= SD_TRACE_DEPTH) {
+        return ring.count > 0 || ring.reboot_reason != REBOOT_REASON_NONE;
+    }
+
+    // Mise sous tension ou contenu corrompu
+    crash_ring_clear();
+    return false;
+}
+
+void crash_ring_record(uint32_t cycle, const cycle_result_t* result) {
+    crash_entry_t* entry = &ring.entries[ring.head];
+
+    entry->cycle = cycle;
+    entry->timestamp_ms = millis();
+    entry->result = *result;
+    entry->crc = entry_crc(entry);
+
+    ring.head = (ring.head + 1) % CRASH_RING_ENTRIES;
+    if (ring.count < CRASH_RING_ENTRIES) ring.count++;
+    ring.trace_count = sd_get_spi_trace(ring.trace, SD_TRACE_DEPTH);
+    seal_header();
+}
+
+void crash_ring_set_reboot_reason(reboot_reason_t reason) {
+    ring.reboot_reason = (uint8_t)reason;
+    ring.trace_count = sd_get_spi_trace(ring.trace, SD_TRACE_DEPTH);
+    seal_header();
+}
+
+void crash_ring_dump_serial(void) {
+    #if SERIAL_DEBUG
+    logger_print_separator();
+    Serial.println(F("=== CRASH RING (previous boot) ==="));
+
+    Serial.print(F("Reboot reason: "));
+    Serial.println(reason_to_string(ring.reboot_reason));
+
+    for (uint8_t i = 0; i < ring.count; i++) {
+        const crash_entry_t* entry = ring_entry(i);
+        if (entry == nullptr) {
+            Serial.println(F("  <corrupted entry>"));
+            continue;
+        }
+        Serial.print(F("  Cycle "));
+        Serial.print(entry->cycle);
+        Serial.print(F(" @"));
+        Serial.print(entry->timestamp_ms);
+        Serial.print(F("ms: "));
+        if (entry->result.success) {
+            Serial.print(F("OK"));
+        } else {
+            Serial.print(F("FAIL ("));
+            Serial.print(logger_error_to_string(entry->result.error_code));
+            Serial.print(')');
+        }
+        Serial.print(F(" | Init: "));
+        Serial.print(entry->result.init_time_us);
+        Serial.print(F("us | Write: "));
+        Serial.print(entry->result.write_time_us);
+        Serial.print(F("us | SPI: "));
+        Serial.print(entry->result.spi_freq_used / 1000);
+        Serial.println(F("kHz"));
+    }
+
+    Serial.print(F("SPI trace (CMD/arg/R1):"));
+    for (uint8_t i = 0; i < ring.trace_count; i++) {
+        Serial.print(F(" CMD"));
+        Serial.print(ring.trace[i].cmd);
+        Serial.print('/');
+        Serial.print(ring.trace[i].arg, HEX);
+        Serial.print('/');
+        Serial.print(ring.trace[i].response, HEX);
+    }
+    Serial.println();
+    logger_print_separator();
+    #endif
+}
+
+/**
+ * Écrit les lignes #CRASH dans le texte emprunté par crash_ring_dump_to_card
+ */
+static sd_error_t dump_lines(char* text, uint16_t size) {
+    sd_error_t err;
+
+    snprintf(text, size, "CRASH,reason,%s", (const char*)reason_to_string(ring.reboot_reason));
+    err = sd_write_log_comment(text);
+    if (err != ERR_NONE) return err;
+
+    for (uint8_t i = 0; i < ring.count; i++) {
+        const crash_entry_t* entry = ring_entry(i);
+        if (entry == nullptr) continue;
+
+        snprintf(text, size, "CRASH,cycle,%lu,%lu,%s,%d,%lu,%lu,%lu",
+                 entry->cycle,
+                 entry->timestamp_ms,
+                 entry->result.success ? "OK" : "FAIL",
+                 (int)entry->result.error_code,
+                 entry->result.init_time_us,
+                 entry->result.write_time_us,
+                 entry->result.spi_freq_used);
+        err = sd_write_log_comment(text);
+        if (err != ERR_NONE) return err;
+    }
+
+    for (uint8_t i = 0; i < ring.trace_count; i++) {
+        snprintf(text, size, "CRASH,spi,%u,%08lX,%02X",
+                 ring.trace[i].cmd, ring.trace[i].arg, ring.trace[i].response);
+        err = sd_write_log_comment(text);
+        if (err != ERR_NONE) return err;
+    }
+
+    return ERR_NONE;
+}
+
+sd_error_t crash_ring_dump_to_card(void) {
+    // Texte emprunté à l'arena, sd_write_log_comment y ajoute '#' et '\n'
+    ram_lease_t lease;
+    char* text = (char*)ram_lease(&lease, CSV_LINE_MAX_SIZE - 2);
+    sd_error_t err = (text != nullptr) ? dump_lines(text, CSV_LINE_MAX_SIZE - 2) : ERR_BUFFER_OVERFLOW;
+    ram_release(&lease);
+    return err;
+}
+
+void crash_ring_clear(void) {
+    memset(&ring, 0, sizeof(ring));
+    ring.magic = CRASH_RING_MAGIC;
+    seal_header();
+}
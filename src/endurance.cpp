@@ -0,0 +1,283 @@
+/**
+ * @file endurance.cpp
+ * @brief Implémentation du test d'endurance
+ */
+
+#include "endurance.h"
+#include "sd_controller.h"
+#include "crc32.h"
+#include "ram.h"
+
+// =============================================================================
+// FORMAT DU FICHIER D'USURE
+// =============================================================================
+
+#define ENDURANCE_MAGIC     0x32574453UL    // "SDW2": attentes sur 32 bits
+#define RECORDS_PER_SECTOR  (512 / sizeof(wear_record_t))
+#define MAX_RECORDS         ((ENDURANCE_LOG_SECTORS - 1) * RECORDS_PER_SECTOR)
+
+// Secteur 0: état, protégé par CRC, réécrit à chaque cycle et à chaque point de la courbe
+typedef struct {
+    uint32_t magic;
+    uint16_t window;                    // ENDURANCE_SECTORS à la création
+    uint8_t worn;
+    uint8_t worn_sector;
+    uint32_t worn_pass;
+    uint32_t passes;
+    uint32_t rewrites;
+    uint32_t records;
+    uint32_t first_avg_busy_us;
+    uint32_t last_avg_busy_us;
+    uint32_t max_busy_us;
+    uint32_t writes[ENDURANCE_SECTORS];
+    uint32_t crc;
+} wear_header_t;
+
+static_assert(sizeof(wear_header_t) <= 512, "ENDURANCE_SECTORS: en-tête d'usure limité à un secteur");
+
+// Secteurs 1..: un point de la courbe par ENDURANCE_RECORD_INTERVAL passes
+// (attentes sur 32 bits: une carte usée dépasse 65 ms)
+typedef struct {
+    uint32_t passes;
+    uint32_t avg_busy_us;               // Attente moyenne par écriture sur l'intervalle
+    uint32_t max_busy_us;               // Pire attente sur l'intervalle
+} wear_record_t;
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+static endurance_stats_t stats;
+static bool state_loaded = false;
+static uint8_t* io_buffer = nullptr;    // Secteur emprunté à l'arena pendant le cycle
+
+// Accumulation de l'intervalle en cours
+static uint32_t interval_busy_us = 0;
+static uint32_t interval_writes = 0;
+static uint32_t interval_max_busy_us = 0;
+
+// =============================================================================
+// FONCTIONS INTERNES
+// =============================================================================
+
+// Motif d'une passe: 0x55/0xAA alternés pour basculer toutes les cellules,
+// passe et index en tête pour reconnaître un secteur déplacé
+static uint8_t pattern_byte(uint32_t pass, uint8_t sector, uint16_t i) {
+    if (i < 4) {
+        return (uint8_t)(pass >> (8 * i));
+    }
+    if (i == 4) {
+        return sector;
+    }
+    return (pass & 1) ? 0xAA : 0x55;
+}
+
+static bool save_header(uint32_t log_lba) {
+    wear_header_t header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic = ENDURANCE_MAGIC;
+    header.window = ENDURANCE_SECTORS;
+    header.worn = stats.worn;
+    header.worn_sector = stats.worn_sector;
+    header.worn_pass = stats.worn_pass;
+    header.passes = stats.passes;
+    header.rewrites = stats.rewrites;
+    header.records = stats.records;
+    header.first_avg_busy_us = stats.first_avg_busy_us;
+    header.last_avg_busy_us = stats.last_avg_busy_us;
+    header.max_busy_us = stats.max_busy_us;
+    memcpy(header.writes, stats.writes, sizeof(header.writes));
+    header.crc = crc32_compute(&header, offsetof(wear_header_t, crc));
+
+    memset(io_buffer, 0, 512);
+    memcpy(io_buffer, &header, sizeof(header));
+    return sd_write_sector(log_lba, io_buffer);
+}
+
+// Reprend l'état d'une session précédente (même taille de fenêtre)
+static bool load_header(uint32_t log_lba) {
+    if (!sd_read_sector(log_lba, io_buffer)) {
+        return false;
+    }
+
+    wear_header_t header;
+    memcpy(&header, io_buffer, sizeof(header));
+    if (header.magic != ENDURANCE_MAGIC || header.window != ENDURANCE_SECTORS ||
+        header.crc != crc32_compute(&header, offsetof(wear_header_t, crc))) {
+        return true;    // Nouveau test
+    }
+
+    stats.worn = header.worn;
+    stats.worn_sector = header.worn_sector;
+    stats.worn_pass = header.worn_pass;
+    stats.passes = header.passes;
+    stats.rewrites = header.rewrites;
+    stats.records = header.records;
+    stats.first_avg_busy_us = header.first_avg_busy_us;
+    stats.last_avg_busy_us = header.last_avg_busy_us;
+    stats.max_busy_us = header.max_busy_us;
+    memcpy(stats.writes, header.writes, sizeof(stats.writes));
+    return true;
+}
+
+// Ajoute un point de la courbe (lecture-modification-écriture du secteur)
+static bool append_record(uint32_t log_lba) {
+    wear_record_t record;
+    record.passes = stats.passes;
+    record.avg_busy_us = interval_writes ? interval_busy_us / interval_writes : 0;
+    record.max_busy_us = interval_max_busy_us;
+
+    if (stats.records == 0) {
+        stats.first_avg_busy_us = record.avg_busy_us;
+    }
+    stats.last_avg_busy_us = record.avg_busy_us;
+
+    // Fichier plein: les compteurs continuent, la courbe s'arrête
+    if (stats.records < MAX_RECORDS) {
+        uint32_t lba = log_lba + 1 + stats.records / RECORDS_PER_SECTOR;
+        uint16_t offset = (stats.records % RECORDS_PER_SECTOR) * sizeof(wear_record_t);
+
+        if (offset == 0) {
+            memset(io_buffer, 0, 512);
+        } else if (!sd_read_sector(lba, io_buffer)) {
+            return false;
+        }
+        memcpy(&io_buffer[offset], &record, sizeof(record));
+        if (!sd_write_sector(lba, io_buffer)) {
+            return false;
+        }
+        stats.records++;
+    }
+
+    interval_busy_us = 0;
+    interval_writes = 0;
+    interval_max_busy_us = 0;
+    return save_header(log_lba);
+}
+
+// Écrit un secteur de la fenêtre en mesurant l'attente de programmation
+static bool write_sector(uint32_t lba, uint8_t sector) {
+    for (uint16_t i = 0; i < 512; i++) {
+        io_buffer[i] = pattern_byte(stats.passes, sector, i);
+    }
+
+    uint32_t busy_start = sd_get_busy_time_us();
+    sd_reset_busy_max();
+    if (!sd_write_sector(lba, io_buffer)) {
+        return false;
+    }
+
+    uint32_t busy = sd_get_busy_time_us() - busy_start;
+    uint32_t busy_max = sd_get_busy_max_us();
+    stats.writes[sector]++;
+    interval_busy_us += busy;
+    interval_writes++;
+    if (busy_max > interval_max_busy_us) {
+        interval_max_busy_us = busy_max;
+    }
+    if (busy_max > stats.max_busy_us) {
+        stats.max_busy_us = busy_max;
+    }
+    return true;
+}
+
+static bool sector_matches(uint8_t sector) {
+    for (uint16_t i = 0; i < 512; i++) {
+        if (io_buffer[i] != pattern_byte(stats.passes, sector, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+void endurance_init(void) {
+    memset(&stats, 0, sizeof(stats));
+    state_loaded = false;
+    interval_busy_us = 0;
+    interval_writes = 0;
+    interval_max_busy_us = 0;
+}
+
+static sd_error_t run_cycle(void) {
+    uint32_t base, log_lba;
+    sd_error_t err = sd_scratch_open(SCRATCH_FILE_SECTORS, &base);
+    if (err == ERR_NONE) {
+        err = sd_contig_file_open(ENDURANCE_LOG_FILE, ENDURANCE_LOG_SECTORS, &log_lba);
+    }
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    if (!state_loaded) {
+        if (!load_header(log_lba)) {
+            return ERR_FILE_READ_FAILED;
+        }
+        state_loaded = true;
+    }
+    if (stats.worn) {
+        return ERR_SECTOR_WORN;
+    }
+
+    uint32_t window = base + WORKLOAD_SCRATCH_SECTORS + VERIFY_RING_SECTORS;
+
+    for (uint8_t p = 0; p < ENDURANCE_PASSES_PER_CYCLE; p++) {
+        for (uint8_t s = 0; s < ENDURANCE_SECTORS; s++) {
+            if (!write_sector(window + s, s)) {
+                return ERR_FILE_WRITE_FAILED;
+            }
+        }
+
+        for (uint8_t s = 0; s < ENDURANCE_SECTORS; s++) {
+            if (!sd_read_sector(window + s, io_buffer)) {
+                return ERR_FILE_READ_FAILED;
+            }
+            if (sector_matches(s)) {
+                continue;
+            }
+
+            // Une réécriture, puis erreur non corrigible
+            if (!write_sector(window + s, s) || !sd_read_sector(window + s, io_buffer)) {
+                return ERR_FILE_WRITE_FAILED;
+            }
+            if (!sector_matches(s)) {
+                stats.worn = true;
+                stats.worn_sector = s;
+                stats.worn_pass = stats.passes;
+                append_record(log_lba);
+                return ERR_SECTOR_WORN;
+            }
+            stats.rewrites++;
+        }
+
+        stats.passes++;
+        if (stats.passes % ENDURANCE_RECORD_INTERVAL == 0 && !append_record(log_lba)) {
+            return ERR_FILE_WRITE_FAILED;
+        }
+    }
+
+    // Compteurs sauvés à chaque cycle: un reboot ne perd pas les passes
+    // écrites depuis le dernier point de la courbe
+    if (!save_header(log_lba)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    return ERR_NONE;
+}
+
+sd_error_t endurance_run_cycle(void) {
+    ram_lease_t lease;
+    io_buffer = (uint8_t*)ram_lease(&lease, 512);
+    sd_error_t err = (io_buffer != nullptr) ? run_cycle() : ERR_BUFFER_OVERFLOW;
+    ram_release(&lease);
+    io_buffer = nullptr;
+    return err;
+}
+
+const endurance_stats_t* endurance_get_stats(void) {
+    return &stats;
+}
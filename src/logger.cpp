@@ -4,6 +4,7 @@
  */
 
 #include "logger.h"
+#include "ram.h"
 #include <stdarg.h>
 
 // =============================================================================
@@ -30,6 +31,10 @@ static const char ERR_STR_SD_NOT_PRESENT[] PROGMEM = "SD not present";
 static const char ERR_STR_CARD_TYPE[] PROGMEM = "Unknown card type";
 static const char ERR_STR_FAT_VOLUME[] PROGMEM = "FAT volume failed";
 static const char ERR_STR_BUFFER[] PROGMEM = "Buffer overflow";
+static const char ERR_STR_FILE_READ[] PROGMEM = "File read failed";
+static const char ERR_STR_VOLUME_FULL[] PROGMEM = "Volume full";
+static const char ERR_STR_SECTOR_WORN[] PROGMEM = "Sector worn out";
+static const char ERR_STR_FILE_EXISTS[] PROGMEM = "File exists";
 static const char ERR_STR_UNKNOWN[] PROGMEM = "Unknown error";
 
 // =============================================================================
@@ -88,14 +93,19 @@ void logger_print(uint8_t level, const __FlashStringHelper* format, ...) {
     // Préfixe niveau
     print_level_prefix(level);
 
-    // Message formaté
-    char buffer[128];
-    va_list args;
-    va_start(args, format);
-    vsnprintf_P(buffer, sizeof(buffer), (const char*)format, args);
-    va_end(args);
-
-    Serial.println(buffer);
+    // Message formaté dans l'arena, format brut si elle est pleine
+    ram_lease_t lease;
+    char* buffer = (char*)ram_lease(&lease, LOG_LINE_MAX_SIZE);
+    if (buffer != nullptr) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf_P(buffer, LOG_LINE_MAX_SIZE, (const char*)format, args);
+        va_end(args);
+        Serial.println(buffer);
+    } else {
+        Serial.println(format);
+    }
+    ram_release(&lease);
     #endif
 }
 
@@ -124,11 +134,16 @@ void logger_print_stats(const test_stats_t* stats) {
     Serial.print(F("Total cycles: "));
     Serial.println(stats->total_cycles);
 
+    Serial.print(F("Boot epoch:   "));
+    Serial.println(stats->boot_epoch);
+
     Serial.print(F("Successful:   "));
     Serial.print(stats->successful_cycles);
     Serial.print(F(" ("));
-    if (stats->total_cycles > 0) {
-        Serial.print((stats->successful_cycles * 100) / stats->total_cycles);
+    // Taux sur les cycles comptés, la numérotation pouvant reprendre d'un boot précédent
+    uint32_t counted = stats->successful_cycles + stats->failed_cycles;
+    if (counted > 0) {
+        Serial.print((stats->successful_cycles * 100) / counted);
     } else {
         Serial.print(0);
     }
@@ -163,6 +178,17 @@ void logger_print_stats(const test_stats_t* stats) {
     Serial.print('/');
     Serial.println(stats->max_write_time_us);
 
+    Serial.print(F("Write hist (log2 us):"));
+    for (uint8_t i = 0; i < STATS_HIST_BUCKETS; i++) {
+        if (stats->write_time_hist[i] > 0) {
+            Serial.print(' ');
+            Serial.print(i);
+            Serial.print(':');
+            Serial.print(stats->write_time_hist[i]);
+        }
+    }
+    Serial.println();
+
     Serial.print(F("SPI freq:     "));
     Serial.print(stats->current_spi_freq / 1000);
     Serial.println(F(" kHz"));
@@ -170,6 +196,15 @@ void logger_print_stats(const test_stats_t* stats) {
     Serial.print(F("SPI fallbacks: "));
     Serial.println(stats->spi_fallback_count);
 
+    Serial.print(F("Reboots:      "));
+    Serial.println(stats->reboot_count);
+
+    Serial.print(F("Checkpoints:  "));
+    Serial.print(stats->checkpoint_count);
+    Serial.print(F(" (last "));
+    Serial.print(stats->checkpoint_time_us);
+    Serial.println(F(" us)"));
+
     Serial.print(F("Last error:   "));
     Serial.println(logger_error_to_string(stats->last_error));
 
@@ -213,6 +248,473 @@ void logger_print_sd_info(const char* card_type, uint32_t size_mb) {
     #endif
 }
 
+// Débit en Ko/s (1 Ko = 1024 o) et opérations/s
+static void print_rate(uint64_t bytes, uint32_t ops, uint64_t time_us) {
+    if (time_us == 0) {
+        Serial.print(F("-"));
+        return;
+    }
+    Serial.print((uint32_t)(bytes * 1000000ULL / 1024 / time_us));
+    Serial.print(F(" KB/s "));
+    Serial.print((uint32_t)((uint64_t)ops * 1000000ULL / time_us));
+    Serial.print(F(" IOPS"));
+}
+
+void logger_print_workload(const workload_point_t* points, uint8_t count) {
+    #if SERIAL_DEBUG
+    Serial.println(F("Workload (size pattern: write | read | errors)"));
+    for (uint8_t i = 0; i < count; i++) {
+        const workload_point_t* p = &points[i];
+        if (p->write_ops + p->read_ops == 0) continue;
+
+        Serial.print(F("  "));
+        Serial.print(p->size);
+        Serial.print(p->pattern == WORKLOAD_SEQUENTIAL ? F(" B seq: ") : F(" B rnd: "));
+        print_rate(p->write_bytes, p->write_ops, p->write_time_us);
+        Serial.print(F(" | "));
+        print_rate(p->read_bytes, p->read_ops, p->read_time_us);
+        Serial.print(F(" | "));
+        Serial.println(p->errors);
+    }
+    #endif
+}
+
+void logger_print_verify(const verify_stats_t* stats) {
+    #if SERIAL_DEBUG
+    Serial.print(F("Verify: "));
+    Serial.print(stats->sectors_written);
+    Serial.print(F(" written, "));
+    Serial.print(stats->sectors_read);
+    Serial.print(F(" read, "));
+    Serial.print(stats->sectors_bad);
+    Serial.print(F(" bad ("));
+    Serial.print(stats->crc_failures);
+    Serial.println(F(" CRC)"));
+
+    Serial.print(F("  Write: "));
+    print_rate(stats->write_bytes, stats->sectors_written, stats->write_time_us);
+    Serial.print(F(" | Read: "));
+    print_rate(stats->read_bytes, stats->sectors_read, stats->read_time_us);
+    Serial.println();
+
+    if (stats->sectors_bad > 0) {
+        Serial.print(F("  Bit errors (bit 0-7):"));
+        for (uint8_t b = 0; b < 8; b++) {
+            Serial.print(' ');
+            Serial.print(stats->bit_errors[b]);
+        }
+        Serial.print(F(" | By age:"));
+        for (uint8_t a = 0; a < VERIFY_READBACK_SECTORS; a++) {
+            Serial.print(' ');
+            Serial.print(stats->age_errors[a]);
+        }
+        Serial.print(F(" | Last LBA "));
+        Serial.println(stats->last_bad_lba);
+    }
+
+    for (uint8_t i = 0; i < VERIFY_FREQ_SLOTS; i++) {
+        const verify_freq_point_t* p = &stats->freq[i];
+        if (p->freq_hz == 0) break;
+        Serial.print(F("  @ "));
+        Serial.print(p->freq_hz / 1000);
+        Serial.print(F(" kHz: "));
+        Serial.print(p->sectors_bad);
+        Serial.print('/');
+        Serial.print(p->sectors_read);
+        Serial.print(F(" bad sectors, "));
+        Serial.print(p->bit_errors);
+        Serial.println(F(" bit errors"));
+    }
+    #endif
+}
+
+void logger_print_bench(const bench_result_t* results, uint8_t count) {
+    #if SERIAL_DEBUG
+    char line[120];
+
+    Serial.println(F("Benchmark (latency per sector, us)"));
+    Serial.println(F("   kHz mode   dir      KB/s   IOPS    p50    p90    p99  p99.9    max busy% busymax erase_us err"));
+    for (uint8_t i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        uint32_t kbps = r->time_us ? (uint32_t)((uint64_t)r->sectors * 512 * 1000000ULL / 1024 / r->time_us) : 0;
+        uint32_t iops = r->time_us ? (uint32_t)((uint64_t)r->sectors * 1000000ULL / r->time_us) : 0;
+        uint32_t busy_pct = r->time_us ? (uint32_t)((uint64_t)r->busy_us * 100 / r->time_us) : 0;
+
+        snprintf(line, sizeof(line), "%6lu %-6s %-5s %7lu %6lu %6lu %6lu %6lu %6lu %6lu %4lu%% %7lu %8lu %lu",
+                 (unsigned long)(r->freq_hz / 1000), bench_mode_name(r->mode), r->is_write ? "write" : "read",
+                 (unsigned long)kbps, (unsigned long)iops,
+                 (unsigned long)r->p50_us, (unsigned long)r->p90_us,
+                 (unsigned long)r->p99_us, (unsigned long)r->p999_us, (unsigned long)r->max_us,
+                 (unsigned long)busy_pct, (unsigned long)r->busy_max_us,
+                 (unsigned long)r->erase_us, (unsigned long)r->errors);
+        Serial.println(line);
+    }
+
+    // Histogrammes des passes aléatoires (classes non vides)
+    for (uint8_t w = 0; w < 2; w++) {
+        const uint16_t* hist;
+        uint8_t buckets = bench_get_random_hist(w == 0, &hist);
+
+        Serial.print(w == 0 ? F("Random write latency:") : F("Random read latency:"));
+        for (uint8_t b = 0; b < buckets; b++) {
+            if (hist[b] == 0) continue;
+            Serial.print(F(" >="));
+            Serial.print(bench_hist_floor(b));
+            Serial.print(':');
+            Serial.print(hist[b]);
+        }
+        Serial.println();
+    }
+    #endif
+}
+
+void logger_print_endurance(const endurance_stats_t* stats) {
+    #if SERIAL_DEBUG
+    uint32_t min_writes = UINT32_MAX, max_writes = 0;
+    for (uint8_t i = 0; i < ENDURANCE_SECTORS; i++) {
+        if (stats->writes[i] < min_writes) min_writes = stats->writes[i];
+        if (stats->writes[i] > max_writes) max_writes = stats->writes[i];
+    }
+
+    Serial.print(F("Endurance: "));
+    Serial.print(stats->passes);
+    Serial.print(F(" passes | writes/sector "));
+    Serial.print(min_writes);
+    Serial.print('-');
+    Serial.print(max_writes);
+    Serial.print(F(" | rewrites "));
+    Serial.println(stats->rewrites);
+
+    Serial.print(F("  Busy avg "));
+    Serial.print(stats->first_avg_busy_us);
+    Serial.print(F(" -> "));
+    Serial.print(stats->last_avg_busy_us);
+    Serial.print(F(" us | max "));
+    Serial.print(stats->max_busy_us);
+    Serial.print(F(" us | "));
+    Serial.print(stats->records);
+    Serial.println(F(" wear records"));
+
+    if (stats->worn) {
+        Serial.print(F("  WORN: sector "));
+        Serial.print(stats->worn_sector);
+        Serial.print(F(" at pass "));
+        Serial.println(stats->worn_pass);
+    }
+    #endif
+}
+
+void logger_print_latency_map(const sd_latency_bucket_t* map, uint8_t count,
+                              uint32_t bucket_sectors, uint32_t median_us) {
+    #if SERIAL_DEBUG
+    Serial.print(F("Latency map: "));
+    Serial.print(count);
+    Serial.print(F(" buckets of "));
+    Serial.print(bucket_sectors);
+    Serial.print(F(" sectors | median "));
+    Serial.print(median_us);
+    Serial.println(F(" us"));
+
+    // Seules les tranches lentes sont détaillées
+    for (uint8_t i = 0; i < count; i++) {
+        if (!map[i].slow) continue;
+        Serial.print(F("  SLOW seq "));
+        Serial.print(map[i].first_sequence);
+        Serial.print(F(": avg "));
+        Serial.print(map[i].avg_busy_us);
+        Serial.print(F(" us, max "));
+        Serial.print(map[i].max_busy_us);
+        Serial.print(F(" us ("));
+        Serial.print(map[i].writes);
+        Serial.println(F(" writes)"));
+    }
+    #endif
+}
+
+void logger_print_format(const sd_format_info_t* info) {
+    #if SERIAL_DEBUG
+    Serial.print(F("Format: partition at "));
+    Serial.print(info->partition_start);
+    Serial.print(F(" ("));
+    Serial.print(info->partition_sectors / 2048);
+    Serial.print(F(" MB) | align "));
+    Serial.print(info->align_sectors / 2);
+    Serial.print(F(" KB | cluster "));
+    Serial.print(info->cluster_sectors * 512UL);
+    Serial.print(F(" B x "));
+    Serial.println(info->clusters);
+
+    Serial.print(F("  FAT "));
+    Serial.print(info->fat_sectors);
+    Serial.print(F(" sectors x2 | reserved "));
+    Serial.print(info->reserved_sectors);
+    Serial.print(F(" | data at "));
+    Serial.print(info->data_start);
+    Serial.print(F(" | log "));
+    Serial.print(info->log_sectors / 2048);
+    Serial.print(F(" MB | "));
+    Serial.print(info->time_us / 1000);
+    Serial.println(F(" ms"));
+    #endif
+}
+
+void logger_print_churn(const churn_stats_t* stats) {
+    #if SERIAL_DEBUG
+    static const char* const op_names[CHURN_OP_COUNT] = {
+        "create", "append", "truncate", "rename", "delete"
+    };
+    char line[96];
+
+    Serial.print(F("Metadata churn: "));
+    Serial.print(stats->files);
+    Serial.print(F(" files | longest dir scan "));
+    Serial.print(stats->max_dir_sectors);
+    Serial.println(F(" sectors"));
+    Serial.println(F("  op          count  scan  entry    fat   data    max (avg us) err"));
+
+    for (uint8_t i = 0; i < CHURN_OP_COUNT; i++) {
+        const churn_op_stats_t* s = &stats->ops[i];
+        if (s->count == 0) continue;
+
+        snprintf(line, sizeof(line), "  %-9s %7lu %5lu %6lu %6lu %6lu %6lu %lu",
+                 op_names[i], (unsigned long)s->count,
+                 (unsigned long)(s->scan_us / s->count), (unsigned long)(s->entry_us / s->count),
+                 (unsigned long)(s->fat_us / s->count), (unsigned long)(s->data_us / s->count),
+                 (unsigned long)s->max_us, (unsigned long)s->errors);
+        Serial.println(line);
+    }
+
+    Serial.print(F("  Scan by dir size:"));
+    for (uint8_t i = 0; i < CHURN_SIZE_CLASSES; i++) {
+        const churn_size_stats_t* s = &stats->sizes[i];
+        if (s->ops == 0) continue;
+        Serial.print(F(" "));
+        Serial.print(1UL << i);
+        Serial.print(F("+ sect "));
+        Serial.print((uint32_t)(s->scan_us / s->ops));
+        Serial.print(F(" us |"));
+    }
+    Serial.println();
+    #endif
+}
+
+void logger_print_ram(const ram_stats_t* stats) {
+    #if SERIAL_DEBUG
+    Serial.print(F("RAM: arena peak "));
+    Serial.print(stats->arena_high_water);
+    Serial.print(F("/"));
+    Serial.print(stats->arena_size);
+    Serial.print(F(" bytes"));
+    if (stats->lease_failures > 0) {
+        Serial.print(F(" ("));
+        Serial.print(stats->lease_failures);
+        Serial.print(F(" refused)"));
+    }
+    if (stats->stack_painted > 0) {
+        Serial.print(F(" | stack peak "));
+        Serial.print(stats->stack_high_water);
+        Serial.print(F("/"));
+        Serial.print(stats->stack_painted);
+        Serial.print(F(" bytes below setup()"));
+    }
+    Serial.println();
+    #endif
+}
+
+void logger_print_card_id(const sd_card_id_t* id, const card_profile_t* profile) {
+    #if SERIAL_DEBUG
+    char line[96];
+    snprintf(line, sizeof(line), "Card ID: MID %02X OEM %.2s %.5s rev %u.%u SN %08lX (%02u/%u)",
+             id->manufacturer_id, id->oem_id, id->product,
+             id->revision >> 4, id->revision & 0x0F,
+             id->serial, id->mfg_month, id->mfg_year);
+    Serial.println(line);
+
+    Serial.print(F("CSD: "));
+    Serial.print(id->sectors / 2048);
+    Serial.print(F(" MB | TRAN_SPEED "));
+    Serial.print(id->tran_speed_khz);
+    Serial.print(F(" kHz | R2W x"));
+    Serial.print(1 << id->r2w_factor);
+    Serial.print(F(" | Write block "));
+    Serial.print(1UL << id->write_bl_len);
+    Serial.print(F(" | Erase unit "));
+    Serial.println(id->erase_unit_sectors);
+
+    if (profile != nullptr) {
+        Serial.print(F("Profile: SPI "));
+        Serial.print(profile->spi_freq_hz / 1000);
+        Serial.print(F(" kHz | settle "));
+        Serial.print(profile->settle_ms);
+        Serial.print(F(" ms | batch "));
+        Serial.println(profile->batch_lines);
+    } else {
+        Serial.println(F("Profile: none (defaults)"));
+    }
+    #endif
+}
+
+void logger_print_card_status(const sd_card_status_t* status) {
+    #if SERIAL_DEBUG
+    Serial.print(F("SD Status: AU "));
+    Serial.print(status->au_sectors / 2);
+    Serial.print(F(" KB | Class "));
+    Serial.print(status->speed_class);
+    Serial.print(F(" | Erase "));
+    Serial.print(status->erase_size_au);
+    Serial.print(F(" AU in "));
+    Serial.print(status->erase_timeout_s);
+    Serial.print(F("+"));
+    Serial.print(status->erase_offset_s);
+    Serial.println(F(" s"));
+    #endif
+}
+
+// Type de volume: FAT16, FAT32 ou exFAT
+static void print_fs_type(const sd_fs_stats_t* fs_stats) {
+    if (fs_stats->fat_bits == 0) {
+        Serial.print(F("exFAT"));
+    } else {
+        Serial.print(F("FAT"));
+        Serial.print(fs_stats->fat_bits);
+    }
+}
+
+void logger_print_fs_stats(const sd_fs_stats_t* fs_stats) {
+    #if SERIAL_DEBUG
+    Serial.print(F("Volume: "));
+    print_fs_type(fs_stats);
+    Serial.print(F(" at sector "));
+    Serial.print(fs_stats->volume_start);
+    if (fs_stats->partition_type != 0) {
+        Serial.print(F(" (MBR type 0x"));
+        Serial.print(fs_stats->partition_type, HEX);
+        Serial.print(F(")"));
+    } else {
+        Serial.print(F(" (no partition table)"));
+    }
+    if (fs_stats->volume_detect_reads > 0) {
+        Serial.print(F(" | detect "));
+        Serial.print(fs_stats->volume_detect_reads);
+        Serial.println(F(" sectors"));
+    } else {
+        Serial.println(F(" | cached"));
+    }
+
+    Serial.print(F("Log tail: sector "));
+    Serial.print(fs_stats->log_tail_sector);
+    Serial.print(F(" +"));
+    Serial.print(fs_stats->log_tail_offset);
+    Serial.print(F(" bytes | Recovery: "));
+    Serial.print(fs_stats->recovery_probes);
+    Serial.print(F(" probes in "));
+    Serial.print(fs_stats->recovery_time_us);
+    Serial.println(F(" us"));
+
+    Serial.print(F("Log extents: "));
+    Serial.print(fs_stats->log_extents);
+    if (fs_stats->log_extents_dropped > 0) {
+        Serial.print(F(" ("));
+        Serial.print(fs_stats->log_extents_dropped);
+        Serial.print(F(" dropped)"));
+    }
+    Serial.println();
+
+    if (fs_stats->au_same_writes + fs_stats->au_crossings > 0) {
+        Serial.print(F("AU writes: "));
+        Serial.print(fs_stats->au_same_writes);
+        Serial.print(F(" same AU / "));
+        Serial.print(fs_stats->au_crossings);
+        Serial.println(F(" crossings"));
+    }
+
+    if (fs_stats->log_file_number > 0) {
+        Serial.print(F("Log file: SD_"));
+        char number[8];
+        snprintf(number, sizeof(number), "%05lu", (unsigned long)fs_stats->log_file_number);
+        Serial.print(number);
+        Serial.print(F(".CSV | "));
+        Serial.print(fs_stats->log_rotations);
+        Serial.print(F(" rotations"));
+        if (fs_stats->log_rotations > 0) {
+            Serial.print(F(" (last "));
+            Serial.print(fs_stats->log_rotate_time_us);
+            Serial.print(F(" us)"));
+        }
+        if (fs_stats->log_index_scan_sectors > 0) {
+            Serial.print(F(" | no index, "));
+            Serial.print(fs_stats->log_index_scan_sectors);
+            Serial.print(F(" dir sectors scanned"));
+        }
+        Serial.println();
+    }
+
+    Serial.print(F("Dir lookup: "));
+    Serial.print(fs_stats->dir_lookup_sectors);
+    Serial.print(F(" sectors in "));
+    Serial.print(fs_stats->dir_lookup_time_us);
+    Serial.println(fs_stats->dir_cache_hit ? F(" us (cached)") : F(" us"));
+
+    if (fs_stats->alloc_count > 0) {
+        Serial.print(F("Cluster alloc ("));
+        print_fs_type(fs_stats);
+        Serial.print(F("): "));
+        Serial.print(fs_stats->alloc_count);
+        Serial.print(F(" | avg "));
+        Serial.print(fs_stats->alloc_total_us / fs_stats->alloc_count);
+        Serial.print(F(" us | max "));
+        Serial.print(fs_stats->alloc_max_us);
+        Serial.print(F(" us | FAT reads "));
+        Serial.println(fs_stats->alloc_fat_reads);
+    }
+
+    if (fs_stats->erase_count > 0) {
+        Serial.print(F("Erase: "));
+        Serial.print(fs_stats->erase_count);
+        Serial.print(F(" cmds | "));
+        Serial.print(fs_stats->erase_sectors);
+        Serial.print(F(" sectors | avg "));
+        Serial.print(fs_stats->erase_total_us / fs_stats->erase_count);
+        Serial.print(F(" us | max "));
+        Serial.print(fs_stats->erase_max_us);
+        Serial.print(F(" us"));
+        if (fs_stats->erase_errors > 0) {
+            Serial.print(F(" | "));
+            Serial.print(fs_stats->erase_errors);
+            Serial.print(F(" failed"));
+        }
+        Serial.println();
+    }
+
+    Serial.print(F("FAT cache: "));
+    Serial.print(fs_stats->fat_cache_hits);
+    Serial.print(F(" hits / "));
+    Serial.print(fs_stats->fat_cache_misses);
+    Serial.print(F(" misses | FAT writes: "));
+    Serial.print(fs_stats->fat_writes);
+    if (fs_stats->log_bytes_appended > 0) {
+        Serial.print(F(" ("));
+        Serial.print((uint32_t)((uint64_t)fs_stats->fat_writes * 1048576UL / fs_stats->log_bytes_appended));
+        Serial.print(F("/MB)"));
+    }
+    Serial.println();
+
+    if (fs_stats->tail_switches > 0) {
+        Serial.print(F("Shared tail: "));
+        Serial.print(fs_stats->tail_switches);
+        Serial.print(F(" switches | "));
+        Serial.print(fs_stats->tail_reloads);
+        Serial.println(F(" reloads"));
+    }
+
+    if (fs_stats->latency_slow_buckets > 0) {
+        Serial.print(F("Latency map: "));
+        Serial.print(fs_stats->latency_slow_buckets);
+        Serial.println(F(" slow bucket(s)"));
+    }
+    #endif
+}
+
 void logger_print_banner(void) {
     #if SERIAL_DEBUG
     Serial.println();
@@ -290,6 +792,14 @@ const __FlashStringHelper* logger_error_to_string(sd_error_t error) {
             return (__FlashStringHelper*)ERR_STR_FAT_VOLUME;
         case ERR_BUFFER_OVERFLOW:
             return (__FlashStringHelper*)ERR_STR_BUFFER;
+        case ERR_FILE_READ_FAILED:
+            return (__FlashStringHelper*)ERR_STR_FILE_READ;
+        case ERR_VOLUME_FULL:
+            return (__FlashStringHelper*)ERR_STR_VOLUME_FULL;
+        case ERR_SECTOR_WORN:
+            return (__FlashStringHelper*)ERR_STR_SECTOR_WORN;
+        case ERR_FILE_EXISTS:
+            return (__FlashStringHelper*)ERR_STR_FILE_EXISTS;
         default:
             return (__FlashStringHelper*)ERR_STR_UNKNOWN;
     }
@@ -18,6 +18,13 @@
 #include "sd_controller.h"
 #include "power_cycle.h"
 #include "logger.h"
+#include "crash_ring.h"
+#include "workload.h"
+#include "verify.h"
+#include "bench.h"
+#include "endurance.h"
+#include "churn.h"
+#include "ram.h"
 
 // =============================================================================
 // VARIABLES GLOBALES
@@ -27,6 +34,13 @@ static test_stats_t stats;
 static volatile bool stop_requested = false;
 static uint32_t last_cycle_time = 0;
 
+#if FILE_HANDLE_COUNT > 0
+static int8_t summary_file = -1;
+static int8_t event_file = -1;
+static char event_buffer[EVENT_BUFFER_SIZE];
+static uint16_t event_len = 0;
+#endif
+
 // =============================================================================
 // FONCTIONS PRIVÉES
 // =============================================================================
@@ -48,6 +62,18 @@ static void init_stats(void) {
     stats.current_spi_freq = SD_SPI_FREQUENCY;
 }
 
+/**
+ * @brief Classe log2 d'une durée pour l'histogramme des temps d'écriture
+ */
+static uint8_t hist_bucket(uint32_t time_us) {
+    uint8_t bucket = 0;
+    while (time_us > 1 && bucket < STATS_HIST_BUCKETS - 1) {
+        time_us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
 /**
  * @brief Met à jour les statistiques avec le résultat d'un cycle
  */
@@ -69,6 +95,7 @@ static void update_stats(const cycle_result_t* result) {
 
         // Timing write
         stats.total_write_time_us += result->write_time_us;
+        stats.write_time_hist[hist_bucket(result->write_time_us)]++;
         if (result->write_time_us < stats.min_write_time_us) {
             stats.min_write_time_us = result->write_time_us;
         }
@@ -84,6 +111,174 @@ static void update_stats(const cycle_result_t* result) {
     stats.current_spi_freq = result->spi_freq_used;
 }
 
+#if FILE_HANDLE_COUNT > 0
+/**
+ * @brief Ajoute du texte à un fichier annexe, ouvert au premier usage
+ *
+ * L'en-tête est écrit si le fichier est vide. Le handle reste ouvert d'un
+ * montage à l'autre.
+ */
+static sd_error_t text_file_append(const char* name83, int8_t* file, const char* header,
+                                   const char* text, uint16_t len) {
+    sd_error_t err = ERR_NONE;
+
+    if (*file < 0) {
+        err = sd_file_open(name83, file);
+        if (err == ERR_NONE && sd_file_size(*file) == 0) {
+            err = sd_file_append(*file, header, strlen(header));
+        }
+    }
+    if (err == ERR_NONE) {
+        err = sd_file_append(*file, text, len);
+    }
+    return err;
+}
+
+/**
+ * @brief Met un événement en attente du fichier EVENT_LOG_FILE
+ */
+static void event_record(const char* event, sd_error_t error) {
+    ram_lease_t lease;
+    char* line = (char*)ram_lease(&lease, CSV_LINE_MAX_SIZE);
+    int len = (line != nullptr) ?
+              snprintf(line, CSV_LINE_MAX_SIZE, "%lu,%lu,%lu,%s,%d\n",
+                       millis(), stats.boot_epoch, stats.total_cycles, event, (int)error) : -1;
+    if (len >= 0 && len < CSV_LINE_MAX_SIZE && event_len + (size_t)len <= sizeof(event_buffer)) {
+        memcpy(&event_buffer[event_len], line, len);
+        event_len += len;
+    }
+    ram_release(&lease);
+}
+
+/**
+ * @brief Écrit les événements en attente (carte montée)
+ */
+static void event_flush(void) {
+    if (event_len == 0 || EVENT_LOG_FILE[0] == '\0') {
+        return;
+    }
+
+    sd_error_t err = text_file_append(EVENT_LOG_FILE, &event_file,
+                                      "timestamp_ms,boot_epoch,cycle,event,error_code\n",
+                                      event_buffer, event_len);
+    if (err == ERR_NONE) {
+        event_len = 0;
+        err = sd_file_sync(event_file);
+    }
+    if (err != ERR_NONE) {
+        LOG_WARN("Event log failed: %s", logger_error_to_string(err));
+    }
+}
+
+/**
+ * @brief Ajoute une ligne de statistiques cumulées à STATS_SUMMARY_FILE
+ */
+static void summary_append(void) {
+    if (STATS_SUMMARY_FILE[0] == '\0') {
+        return;
+    }
+
+    ram_lease_t lease;
+    char* line = (char*)ram_lease(&lease, CSV_LINE_MAX_SIZE);
+    uint32_t avg_write_us = (stats.successful_cycles > 0) ?
+                            stats.total_write_time_us / stats.successful_cycles : 0;
+    int len = (line != nullptr) ?
+              snprintf(line, CSV_LINE_MAX_SIZE, "%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                       stats.boot_epoch, stats.total_cycles, stats.successful_cycles,
+                       stats.failed_cycles, stats.reboot_count, avg_write_us,
+                       stats.max_write_time_us, stats.current_spi_freq) : -1;
+    sd_error_t err = ERR_BUFFER_OVERFLOW;
+    if (len >= 0 && len < CSV_LINE_MAX_SIZE) {
+        err = text_file_append(STATS_SUMMARY_FILE, &summary_file,
+                               "boot_epoch,cycles,success,failed,reboots,avg_write_us,max_write_us,spi_freq_hz\n",
+                               line, (uint16_t)len);
+    }
+    ram_release(&lease);
+    if (err == ERR_NONE) {
+        err = sd_file_sync(summary_file);
+    }
+    if (err != ERR_NONE) {
+        LOG_WARN("Summary not saved: %s", logger_error_to_string(err));
+    }
+}
+#endif
+
+/**
+ * @brief Sauvegarde les statistiques sur la carte (checkpoint A/B)
+ *
+ * Monte la carte si nécessaire (mode agressif). La durée est comptée à part
+ * et n'entre pas dans les statistiques d'écriture.
+ */
+static void checkpoint_stats(void) {
+    uint32_t start = micros();
+    bool was_mounted = sd_is_mounted();
+
+    if (!was_mounted && sd_mount(0) != ERR_NONE) {
+        LOG_WARN_LN("Checkpoint skipped: mount failed");
+        return;
+    }
+
+    stats.checkpoint_count++;
+    sd_error_t err = sd_write_checkpoint(&stats, sizeof(stats));
+
+    // Résumé et événements en attente, hors mesures du cycle
+    #if FILE_HANDLE_COUNT > 0
+    summary_append();
+    event_flush();
+    #endif
+
+    if (!was_mounted) {
+        sd_unmount();
+    }
+    stats.checkpoint_time_us = micros() - start;
+
+    if (err != ERR_NONE) {
+        stats.checkpoint_count--;
+        LOG_WARN("Checkpoint failed: %s", logger_error_to_string(err));
+    }
+}
+
+#if VERIFY_ENABLED
+/**
+ * @brief Écrit et relit les secteurs de contrôle du cycle
+ *
+ * Une corruption n'échoue pas le cycle: elle est comptée par fréquence
+ * pour ne pas fausser la recherche de la fréquence SPI de production.
+ */
+static void run_verify(void) {
+    uint32_t bad_before = verify_get_stats()->sectors_bad;
+    sd_error_t err = verify_run_cycle();
+
+    if (err != ERR_NONE) {
+        LOG_WARN("Verify failed: %s", logger_error_to_string(err));
+    } else if (verify_get_stats()->sectors_bad != bad_before) {
+        LOG_WARN("Verify: %lu corrupted sector(s) at %lu kHz",
+                 verify_get_stats()->sectors_bad - bad_before,
+                 sd_get_current_frequency() / 1000);
+    }
+}
+#endif
+
+#if ENDURANCE_ENABLED
+/**
+ * @brief Exécute les passes d'usure du cycle
+ *
+ * Une erreur d'accès échoue le cycle (retries, repli SPI et reboot
+ * habituels). Un secteur usé arrête le test comme l'appui sur le bouton.
+ */
+static sd_error_t run_endurance(void) {
+    sd_error_t err = endurance_run_cycle();
+
+    if (err == ERR_SECTOR_WORN) {
+        LOG_ERROR_LN("Endurance: uncorrectable error, stopping test");
+        logger_print_endurance(endurance_get_stats());
+        stop_requested = true;
+        return ERR_NONE;
+    }
+    return err;
+}
+#endif
+
 /**
  * @brief Exécute un cycle de test en mode agressif
  *
@@ -153,6 +348,35 @@ static cycle_result_t run_aggressive_cycle(uint32_t cycle_num) {
         return result;
     }
 
+    #if WORKLOAD_ENABLED
+    // Charge d'E/S du cycle, hors temps d'écriture CSV
+    err = workload_run_cycle(cycle_num);
+    if (err != ERR_NONE) {
+        LOG_WARN("Workload failed: %s", logger_error_to_string(err));
+    }
+    #endif
+
+    #if CHURN_ENABLED
+    err = churn_run_cycle();
+    if (err != ERR_NONE) {
+        LOG_WARN("Metadata churn failed: %s", logger_error_to_string(err));
+    }
+    #endif
+
+    #if VERIFY_ENABLED
+    run_verify();
+    #endif
+
+    #if ENDURANCE_ENABLED
+    err = run_endurance();
+    if (err != ERR_NONE) {
+        result.success = false;
+        result.error_code = err;
+        sd_unmount();
+        return result;
+    }
+    #endif
+
     // Unmount
     err = sd_unmount();
     if (err != ERR_NONE) {
@@ -207,6 +431,33 @@ static cycle_result_t run_continuous_cycle(uint32_t cycle_num) {
         return result;
     }
 
+    #if WORKLOAD_ENABLED
+    err = workload_run_cycle(cycle_num);
+    if (err != ERR_NONE) {
+        LOG_WARN("Workload failed: %s", logger_error_to_string(err));
+    }
+    #endif
+
+    #if CHURN_ENABLED
+    err = churn_run_cycle();
+    if (err != ERR_NONE) {
+        LOG_WARN("Metadata churn failed: %s", logger_error_to_string(err));
+    }
+    #endif
+
+    #if VERIFY_ENABLED
+    run_verify();
+    #endif
+
+    #if ENDURANCE_ENABLED
+    err = run_endurance();
+    if (err != ERR_NONE) {
+        result.success = false;
+        result.error_code = err;
+        return result;
+    }
+    #endif
+
     result.success = true;
     result.error_code = ERR_NONE;
     return result;
@@ -223,6 +474,42 @@ static void periodic_stats_display(void) {
     if ((stats.total_cycles - last_stats_cycle >= 100) ||
         (millis() - last_stats_time >= 60000)) {
         logger_print_stats(&stats);
+
+        sd_fs_stats_t fs_stats;
+        sd_get_fs_stats(&fs_stats);
+        logger_print_fs_stats(&fs_stats);
+
+        if (fs_stats.latency_slow_buckets > 0) {
+            // Copie empruntée à l'arena (RAM_LATENCY_MAP_BYTES)
+            ram_lease_t lease;
+            sd_latency_bucket_t* map = (sd_latency_bucket_t*)ram_lease(&lease, RAM_LATENCY_MAP_BYTES);
+            if (map != nullptr) {
+                uint32_t bucket_sectors, median_us;
+                uint8_t count = sd_get_latency_map(map, LATENCY_MAP_BUCKETS, &bucket_sectors, &median_us);
+                logger_print_latency_map(map, count, bucket_sectors, median_us);
+            }
+            ram_release(&lease);
+        }
+
+        #if WORKLOAD_ENABLED
+        const workload_point_t* points;
+        uint8_t count = workload_get_points(&points);
+        logger_print_workload(points, count);
+        #endif
+        #if VERIFY_ENABLED
+        logger_print_verify(verify_get_stats());
+        #endif
+        #if ENDURANCE_ENABLED
+        logger_print_endurance(endurance_get_stats());
+        #endif
+        #if CHURN_ENABLED
+        logger_print_churn(churn_get_stats());
+        #endif
+
+        ram_stats_t ram_stats;
+        ram_get_stats(&ram_stats);
+        logger_print_ram(&ram_stats);
+
         last_stats_time = millis();
         last_stats_cycle = stats.total_cycles;
     }
@@ -233,10 +520,19 @@ static void periodic_stats_display(void) {
 // =============================================================================
 
 void setup() {
-    // Initialisation du logging (doit être en premier)
+    // Pile peinte avant tout appel, pour en mesurer la profondeur maximale
+    ram_stack_paint();
+
+    // Initialisation du logging (avant tout message)
     logger_init();
     logger_print_banner();
 
+    // Diagnostic conservé en RAM depuis le boot précédent
+    bool crash_pending = crash_ring_init();
+    if (crash_pending) {
+        crash_ring_dump_serial();
+    }
+
     // Initialisation du contrôle d'alimentation
     power_init();
     LOG_INFO_LN("Power control initialized");
@@ -252,16 +548,35 @@ void setup() {
     if (!sd_controller_init()) {
         LOG_ERROR_LN("SD controller init failed!");
         led_blink(10, 100, 100);
+        crash_ring_set_reboot_reason(REBOOT_REASON_CONTROLLER_INIT);
         system_reboot();
     }
     LOG_INFO_LN("SD controller initialized");
 
+    #if FORMAT_ENABLED
+    // Bouton maintenu au démarrage: formatage rapide avant le premier montage
+    if (button_is_pressed()) {
+        LOG_INFO_LN("Button held: formatting SD card...");
+        sd_format_info_t format_info;
+        sd_error_t format_err = sd_format(&format_info);
+        if (format_err != ERR_NONE) {
+            LOG_ERROR("Format failed: %s", logger_error_to_string(format_err));
+        } else {
+            logger_print_format(&format_info);
+        }
+        while (button_is_pressed()) {
+            delay(10);
+        }
+    }
+    #endif
+
     // Premier mount pour vérifier la carte
     LOG_INFO_LN("Mounting SD card...");
     sd_error_t err = sd_mount(0);
     if (err != ERR_NONE) {
         LOG_ERROR("Initial mount failed: %s", logger_error_to_string(err));
         led_blink(5, 200, 200);
+        crash_ring_set_reboot_reason(REBOOT_REASON_INITIAL_MOUNT);
         system_reboot();
     }
 
@@ -272,13 +587,99 @@ void setup() {
         logger_print_sd_info(card_type, card_size_mb);
     }
 
-    // Démonte pour commencer proprement
-    #if AGGRESSIVE_MODE
-    sd_unmount();
+    sd_card_status_t card_status;
+    if (sd_get_card_status(&card_status)) {
+        logger_print_card_status(&card_status);
+    }
+
+    // Profil du lot de cartes: le délai de stabilisation relève de l'alimentation
+    sd_card_id_t card_id;
+    if (sd_get_card_id(&card_id)) {
+        const card_profile_t* profile = sd_get_card_profile();
+        logger_print_card_id(&card_id, profile);
+        if (profile != nullptr) {
+            power_set_settle_ms(profile->settle_ms);
+        }
+    }
+
+    // Position de fin de log retrouvée au montage
+    sd_fs_stats_t fs_stats;
+    sd_get_fs_stats(&fs_stats);
+    logger_print_fs_stats(&fs_stats);
+
+    #if BENCH_ENABLED
+    LOG_INFO_LN("Running benchmark...");
+    err = bench_run();
+    const bench_result_t* bench_results;
+    uint8_t bench_count = bench_get_results(&bench_results);
+    logger_print_bench(bench_results, bench_count);
+    if (err != ERR_NONE) {
+        LOG_WARN("Benchmark results not saved: %s", logger_error_to_string(err));
+    }
     #endif
 
     // Initialise les statistiques
     init_stats();
+    #if WORKLOAD_ENABLED
+    workload_init();
+    #endif
+    #if VERIFY_ENABLED
+    verify_init();
+    #endif
+    #if ENDURANCE_ENABLED
+    endurance_init();
+    #endif
+    #if CHURN_ENABLED
+    churn_init();
+    #endif
+    bool resumed = false;
+    uint32_t epoch = 0;
+
+    // Restaure les statistiques cumulées du dernier checkpoint
+    if (sd_read_checkpoint(&stats, sizeof(stats)) == ERR_NONE) {
+        // Repart de zéro sinon un reboot pour échecs se répète immédiatement
+        stats.consecutive_failures = 0;
+        stats.current_spi_freq = SD_SPI_FREQUENCY;
+        epoch = stats.boot_epoch;
+        resumed = true;
+        LOG_INFO("Stats restored from checkpoint (%lu cycles)", stats.total_cycles);
+    }
+
+    // Reprend la numérotation depuis le dernier enregistrement du log,
+    // plus récent que le checkpoint si des cycles ont suivi
+    uint32_t last_cycle, last_epoch;
+    if (sd_get_resume_point(&last_cycle, &last_epoch)) {
+        if (last_cycle > stats.total_cycles) {
+            stats.total_cycles = last_cycle;
+        }
+        if (last_epoch > epoch) {
+            epoch = last_epoch;
+        }
+        resumed = true;
+    }
+
+    stats.boot_epoch = resumed ? epoch + 1 : 0;
+    sd_set_boot_epoch(stats.boot_epoch);
+    if (resumed) {
+        LOG_INFO("Resuming after cycle %lu (boot epoch %lu)", stats.total_cycles, stats.boot_epoch);
+    }
+
+    #if FILE_HANDLE_COUNT > 0
+    event_record(resumed ? "resume" : "boot", ERR_NONE);
+    event_flush();
+    #endif
+
+    // Sauvegarde le diagnostic du boot précédent dans le CSV
+    if (crash_pending && crash_ring_dump_to_card() != ERR_NONE) {
+        LOG_WARN_LN("Crash ring dump to card failed, kept for next boot");
+    } else {
+        crash_ring_clear();
+    }
+
+    // Démonte pour commencer proprement
+    #if AGGRESSIVE_MODE
+    sd_unmount();
+    #endif
 
     LOG_INFO_LN("Starting stress test...");
     logger_print_separator();
@@ -292,6 +693,20 @@ void loop() {
     if (stop_requested) {
         LOG_INFO_LN("Stop requested by user");
         logger_print_stats(&stats);
+        #if WORKLOAD_ENABLED
+        const workload_point_t* points;
+        uint8_t count = workload_get_points(&points);
+        logger_print_workload(points, count);
+        #endif
+        #if VERIFY_ENABLED
+        logger_print_verify(verify_get_stats());
+        #endif
+        #if ENDURANCE_ENABLED
+        logger_print_endurance(endurance_get_stats());
+        #endif
+        #if CHURN_ENABLED
+        logger_print_churn(churn_get_stats());
+        #endif
         sd_unmount();
 
         // LED fixe pour indiquer l'arrêt
@@ -331,10 +746,22 @@ void loop() {
 
     // Met à jour les statistiques
     update_stats(&result);
+    crash_ring_record(stats.total_cycles, &result);
 
     // Affiche le résultat du cycle
     logger_print_cycle_result(stats.total_cycles, &result);
 
+    // Échec noté dans le fichier d'événements, tout de suite si la carte
+    // est encore montée (mode continu), sinon au prochain checkpoint
+    #if FILE_HANDLE_COUNT > 0
+    if (!result.success) {
+        event_record("fail", result.error_code);
+        if (sd_is_mounted()) {
+            event_flush();
+        }
+    }
+    #endif
+
     // Feedback LED
     if (result.success) {
         led_blink(1, 20, 0);  // Court flash pour succès
@@ -348,13 +775,31 @@ void loop() {
         logger_print_stats(&stats);
 
         // Tente un dernier power-cycle
+        sd_unmount();
         power_cycle();
         delay(1000);
 
+        // Sauvegarde des statistiques avant de les perdre
+        stats.reboot_count++;
+        #if FILE_HANDLE_COUNT > 0
+        event_record("reboot", stats.last_error);
+        #endif
+        #if CHECKPOINT_INTERVAL_CYCLES > 0
+        checkpoint_stats();
+        #endif
+
         // Reboot automatique
+        crash_ring_set_reboot_reason(REBOOT_REASON_MAX_FAILURES);
         system_reboot();
     }
 
     // Affichage périodique des stats
     periodic_stats_display();
+
+    // Sauvegarde périodique des statistiques
+    #if CHECKPOINT_INTERVAL_CYCLES > 0
+    if (stats.total_cycles % CHECKPOINT_INTERVAL_CYCLES == 0) {
+        checkpoint_stats();
+    }
+    #endif
 }
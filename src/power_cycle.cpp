@@ -10,6 +10,7 @@
 // =============================================================================
 
 static bool vext_is_on = false;
+static uint16_t power_on_delay_ms = VEXT_POWER_ON_DELAY_MS;
 static void (*button_callback)(void) = nullptr;
 
 // =============================================================================
@@ -48,7 +49,7 @@ void power_on(void) {
     vext_is_on = true;
 
     // Délai de stabilisation
-    delay(VEXT_POWER_ON_DELAY_MS);
+    delay(power_on_delay_ms);
 }
 
 void power_off(void) {
@@ -74,8 +75,12 @@ bool power_is_on(void) {
     return vext_is_on;
 }
 
+void power_set_settle_ms(uint16_t settle_ms) {
+    power_on_delay_ms = (settle_ms > 0) ? settle_ms : VEXT_POWER_ON_DELAY_MS;
+}
+
 uint32_t power_get_cycle_duration_ms(void) {
-    return VEXT_POWER_OFF_DELAY_MS + VEXT_POWER_ON_DELAY_MS;
+    return VEXT_POWER_OFF_DELAY_MS + power_on_delay_ms;
 }
 
 void led_set(bool on) {
@@ -0,0 +1,93 @@
+/**
+ * @file ram.cpp
+ * @brief Implémentation de l'arena de travail et de la mesure de pile
+ */
+
+#include "ram.h"
+
+// =============================================================================
+// CONSTANTES
+// =============================================================================
+
+#define RAM_STACK_PATTERN   0xA5A5A5A5UL
+#define RAM_STACK_GUARD     64      // Marge sous le cadre de l'appelant (octets)
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+static uint32_t arena[(RAM_ARENA_BYTES + 3) / 4];  // Mots: zones alignées sur 4 octets
+static uint16_t arena_top = 0;
+static uint16_t arena_high_water = 0;
+static uint16_t lease_failures = 0;
+
+static uint32_t* paint_low = nullptr;
+static uint32_t* paint_high = nullptr;
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+void* ram_lease(ram_lease_t* lease, uint16_t size) {
+    lease->mark = arena_top;
+
+    uint16_t words = (size + 3) / 4;
+    if (words > sizeof(arena) / 4 - arena_top / 4) {
+        lease_failures++;
+        return nullptr;
+    }
+
+    void* zone = &arena[arena_top / 4];
+    arena_top += words * 4;
+    if (arena_top > arena_high_water) {
+        arena_high_water = arena_top;
+    }
+    return zone;
+}
+
+void ram_release(const ram_lease_t* lease) {
+    if (lease->mark < arena_top) {
+        arena_top = lease->mark;
+    }
+}
+
+void ram_stack_paint(void) {
+    #if RAM_STACK_PAINT && !defined(ESP_PLATFORM)
+    uint8_t top;
+
+    // Du tas (plus une réserve) jusque sous le cadre courant; boucle sans
+    // appel pour ne pas écrire dans la zone pendant qu'on la peint
+    uintptr_t low = ((uintptr_t)sbrk(0) + RAM_HEAP_RESERVE + 3) & ~(uintptr_t)3;
+    uintptr_t high = ((uintptr_t)&top - RAM_STACK_GUARD) & ~(uintptr_t)3;
+    if (high <= low) {
+        return;
+    }
+
+    paint_low = (uint32_t*)low;
+    paint_high = (uint32_t*)high;
+    for (volatile uint32_t* p = paint_low; p < paint_high; p++) {
+        *p = RAM_STACK_PATTERN;
+    }
+    #endif
+}
+
+void ram_get_stats(ram_stats_t* out) {
+    out->arena_size = sizeof(arena);
+    out->arena_high_water = arena_high_water;
+    out->lease_failures = lease_failures;
+    out->stack_painted = 0;
+    out->stack_high_water = 0;
+
+    if (paint_low == nullptr) {
+        return;
+    }
+
+    // Premier mot écrasé en partant du bas: point le plus profond atteint
+    // (un tas qui déborde de sa réserve compte aussi)
+    const volatile uint32_t* p = paint_low;
+    while (p < paint_high && *p == RAM_STACK_PATTERN) {
+        p++;
+    }
+    out->stack_painted = (uint32_t)(paint_high - paint_low) * 4;
+    out->stack_high_water = (uint32_t)(paint_high - p) * 4;
+}
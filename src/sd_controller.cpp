@@ -7,6 +7,9 @@
  */
 
 #include "sd_controller.h"
+#include "crc32.h"
+#include "card_profiles.h"
+#include "ram.h"
 #include <SPI.h>
 
 // =============================================================================
@@ -22,9 +25,15 @@
 #define CMD12   0x0C    // STOP_TRANSMISSION
 #define CMD16   0x10    // SET_BLOCKLEN
 #define CMD17   0x11    // READ_SINGLE_BLOCK
+#define CMD18   0x12    // READ_MULTIPLE_BLOCK
 #define CMD24   0x18    // WRITE_BLOCK
+#define CMD25   0x19    // WRITE_MULTIPLE_BLOCK
+#define CMD32   0x20    // ERASE_WR_BLK_START_ADDR
+#define CMD33   0x21    // ERASE_WR_BLK_END_ADDR
+#define CMD38   0x26    // ERASE
 #define CMD55   0x37    // APP_CMD
 #define CMD58   0x3A    // READ_OCR
+#define ACMD13  0x0D    // SD_STATUS
 #define ACMD41  0x29    // SD_SEND_OP_COND
 
 // Réponses SD
@@ -34,6 +43,29 @@
 // Tokens
 #define TOKEN_START_BLOCK 0xFE
 #define TOKEN_DATA_ACCEPTED 0x05
+#define TOKEN_MULTI_WRITE   0xFC
+#define TOKEN_STOP_TRAN     0xFD
+
+// Valeurs FAT32
+#define FAT32_EOC           0x0FFFFFFFUL    // Fin de chaîne écrite
+#define FAT32_EOC_MIN       0x0FFFFFF8UL    // Toute valeur >= marque la fin
+
+// Secteur FSInfo
+#define FSINFO_LEAD_SIG     0x41615252UL
+#define FSINFO_STRUCT_SIG   0x61417272UL
+#define FSINFO_TRAIL_SIG    0xAA550000UL
+#define FSINFO_UNKNOWN      0xFFFFFFFFUL
+
+// Noms 8.3 dans le répertoire racine
+#define CSV_FILENAME_83     "SD_TEST CSV"
+#define SCRATCH_FILENAME_83 "SCRATCH BIN"
+
+// Colonnes du CSV relues à la reprise
+#define CSV_COL_CYCLE       1
+#define CSV_COL_BOOT_EPOCH  9
+
+// Checkpoint des statistiques
+#define CHECKPOINT_MAGIC    0x4B434453UL    // "SDCK"
 
 // Types de carte
 #define CT_NONE     0
@@ -51,21 +83,60 @@ static uint8_t card_type = CT_NONE;
 static uint32_t current_spi_freq = SD_SPI_FREQUENCY;
 static uint32_t last_init_time_us = 0;
 static uint32_t last_write_time_us = 0;
+static uint32_t busy_time_us = 0;           // Cumul des attentes de fin de programmation
+static uint32_t busy_max_us = 0;            // Plus longue attente depuis la remise à zéro
 static uint32_t card_sectors = 0;
+static uint32_t base_spi_freq = SD_SPI_FREQUENCY;   // Fréquence de départ (profil)
+static bool spi_freq_forced = false;        // Fréquence imposée par l'appelant de sd_mount
+static uint8_t flush_batch_lines = CSV_FLUSH_BATCH_LINES;
+
+// Identification de la carte (CID/CSD) et profil retenu
+static sd_card_id_t card_id;
+static const card_profile_t* card_profile = nullptr;
 
 // Position d'écriture dans le fichier
-static uint32_t csv_next_sector = 0;
+static uint32_t csv_start_sector = 0;       // Secteur de séquence 0 du fichier
+static uint32_t csv_next_seq = 0;           // Séquence (secteur logique) en cours d'écriture
 static uint16_t csv_byte_offset = 0;
+static uint32_t csv_generation = 0;         // Identifiant du journal (en-tête de secteur)
 static uint8_t sector_buffer[512];
 static bool header_written = false;
 
-// Table des fréquences pour fallback
-static const uint32_t spi_freq_table[] = {
+// Secteur de fin du journal gardé en RAM: pas de relecture avant chaque ajout
+static uint8_t log_tail[512];
+static bool log_tail_dirty = false;
+static uint8_t log_tail_lines = 0;          // Ajouts depuis la dernière écriture
+
+// Registre SD Status (ACMD13)
+static sd_card_status_t card_status;
+static uint32_t last_log_au = 0xFFFFFFFFUL; // AU de la dernière écriture du journal
+static uint32_t boot_epoch = 0;             // Colonne boot_epoch du CSV
+static uint16_t lines_since_size_update = 0;
+
+// Métriques du dernier montage
+static sd_fs_stats_t fs_stats;
+
+// Carte de latence du journal: tranche i = secteurs [i << shift, (i+1) << shift)
+typedef struct {
+    uint32_t busy_sum_us;
+    uint16_t writes;
+    uint16_t busy_max_us;
+} latency_bucket_t;
+
+static latency_bucket_t latency_map[LATENCY_MAP_BUCKETS];
+static uint8_t latency_shift = 3;           // 8 secteurs (4 Ko) au départ
+
+// Trace des dernières commandes SD (anneau)
+static sd_trace_entry_t spi_trace[SD_TRACE_DEPTH];
+static uint8_t spi_trace_head = 0;
+static uint8_t spi_trace_count = 0;
+
+// Table des fréquences pour fallback (SD_SPI_FREQ_COUNT entrées)
+static const uint32_t spi_freq_table[SD_SPI_FREQ_COUNT] = {
     4000000UL,   // 4 MHz
     1000000UL,   // 1 MHz
     400000UL     // 400 kHz (minimum)
 };
-static const uint8_t spi_freq_count = sizeof(spi_freq_table) / sizeof(spi_freq_table[0]);
 
 // =============================================================================
 // SOFTWARE SPI
@@ -170,22 +241,21 @@ static uint8_t sd_send_cmd(uint8_t cmd, uint32_t arg) {
         response = spi_transfer(0xFF);
     } while ((response & 0x80) && (++retry < 10));
 
+    // Trace pour le diagnostic post-crash
+    spi_trace[spi_trace_head].arg = arg;
+    spi_trace[spi_trace_head].cmd = cmd;
+    spi_trace[spi_trace_head].response = response;
+    spi_trace_head = (spi_trace_head + 1) % SD_TRACE_DEPTH;
+    if (spi_trace_count < SD_TRACE_DEPTH) spi_trace_count++;
+
     return response;
 }
 
-static bool sd_read_sector(uint32_t sector, uint8_t* buffer) {
+// Lit un bloc de données après une commande acceptée (token, données, CRC ignoré)
+static bool sd_read_data(uint8_t* buffer, uint16_t len) {
     uint8_t response;
     uint16_t retry = 0;
 
-    // Adresse en octets pour SD, en secteurs pour SDHC
-    uint32_t addr = (card_type == CT_SDHC) ? sector : (sector << 9);
-
-    response = sd_send_cmd(CMD17, addr);
-    if (response != 0) {
-        spi_deselect();
-        return false;
-    }
-
     // Attendre le token de début
     while ((response = spi_transfer(0xFF)) == 0xFF) {
         if (++retry > 10000) {
@@ -200,7 +270,7 @@ static bool sd_read_sector(uint32_t sector, uint8_t* buffer) {
     }
 
     // Lire les données
-    for (uint16_t i = 0; i < 512; i++) {
+    for (uint16_t i = 0; i < len; i++) {
         buffer[i] = spi_transfer(0xFF);
     }
 
@@ -212,9 +282,41 @@ static bool sd_read_sector(uint32_t sector, uint8_t* buffer) {
     return true;
 }
 
-static bool sd_write_sector(uint32_t sector, const uint8_t* buffer) {
-    uint8_t response;
+bool sd_read_sector(uint32_t sector, uint8_t* buffer) {
+    // Adresse en octets pour SD, en secteurs pour SDHC
+    uint32_t addr = (card_type == CT_SDHC) ? sector : (sector << 9);
+
+    if (sd_send_cmd(CMD17, addr) != 0) {
+        spi_deselect();
+        return false;
+    }
+
+    return sd_read_data(buffer, 512);
+}
+
+// Attend la fin de programmation (MISO à 0 tant que la carte est occupée)
+static bool sd_wait_not_busy(void) {
+    uint32_t start = micros();
     uint16_t retry = 0;
+    bool ok = true;
+
+    while (spi_transfer(0xFF) == 0) {
+        if (++retry > 50000) {
+            ok = false;
+            break;
+        }
+    }
+
+    uint32_t elapsed = micros() - start;
+    busy_time_us += elapsed;
+    if (elapsed > busy_max_us) {
+        busy_max_us = elapsed;
+    }
+    return ok;
+}
+
+bool sd_write_sector(uint32_t sector, const uint8_t* buffer) {
+    uint8_t response;
 
     // Adresse en octets pour SD, en secteurs pour SDHC
     uint32_t addr = (card_type == CT_SDHC) ? sector : (sector << 9);
@@ -246,226 +348,336 @@ static bool sd_write_sector(uint32_t sector, const uint8_t* buffer) {
     }
 
     // Attendre la fin de l'écriture
-    while (spi_transfer(0xFF) == 0) {
-        if (++retry > 50000) {
-            spi_deselect();
-            return false;
-        }
-    }
-
+    bool ok = sd_wait_not_busy();
     spi_deselect();
-    return true;
+    return ok;
 }
 
-// =============================================================================
-// FONCTIONS FAT32 SIMPLIFIÉES
-// =============================================================================
-
-// Structure du BPB (BIOS Parameter Block)
-static uint16_t bytes_per_sector = 512;
-static uint8_t sectors_per_cluster = 1;
-static uint16_t reserved_sectors = 0;
-static uint8_t num_fats = 2;
-static uint32_t sectors_per_fat = 0;
-static uint32_t root_cluster = 2;
-static uint32_t fat_start_sector = 0;
-static uint32_t data_start_sector = 0;
-static uint32_t total_sectors = 0;
+bool sd_write_multi_begin(uint32_t sector) {
+    uint32_t addr = (card_type == CT_SDHC) ? sector : (sector << 9);
 
-static bool fat32_read_bpb(void) {
-    if (!sd_read_sector(0, sector_buffer)) {
+    if (sd_send_cmd(CMD25, addr) != 0) {
+        spi_deselect();
         return false;
     }
+    return true;
+}
 
-    // Vérifier signature
-    if (sector_buffer[510] != 0x55 || sector_buffer[511] != 0xAA) {
-        // Peut-être une table de partition, chercher la première partition
-        uint32_t part_start = sector_buffer[0x1C6] |
-                              ((uint32_t)sector_buffer[0x1C7] << 8) |
-                              ((uint32_t)sector_buffer[0x1C8] << 16) |
-                              ((uint32_t)sector_buffer[0x1C9] << 24);
+bool sd_write_multi_next(const uint8_t* buffer) {
+    spi_transfer(0xFF);
+    spi_transfer(TOKEN_MULTI_WRITE);
 
-        if (part_start == 0 || !sd_read_sector(part_start, sector_buffer)) {
-            return false;
-        }
-        fat_start_sector = part_start;
-    } else {
-        fat_start_sector = 0;
+    for (uint16_t i = 0; i < 512; i++) {
+        spi_transfer(buffer[i]);
     }
 
-    // Vérifier signature FAT32
-    if (sector_buffer[510] != 0x55 || sector_buffer[511] != 0xAA) {
+    // Dummy CRC
+    spi_transfer(0xFF);
+    spi_transfer(0xFF);
+
+    uint8_t response = spi_transfer(0xFF);
+    if ((response & 0x1F) != TOKEN_DATA_ACCEPTED || !sd_wait_not_busy()) {
+        // Clore le flux: sans STOP_TRAN la carte attend encore des blocs
+        sd_write_multi_end();
         return false;
     }
+    return true;
+}
 
-    // Lire BPB
-    bytes_per_sector = sector_buffer[0x0B] | ((uint16_t)sector_buffer[0x0C] << 8);
-    sectors_per_cluster = sector_buffer[0x0D];
-    reserved_sectors = sector_buffer[0x0E] | ((uint16_t)sector_buffer[0x0F] << 8);
-    num_fats = sector_buffer[0x10];
-
-    // FAT32 specific
-    sectors_per_fat = sector_buffer[0x24] |
-                      ((uint32_t)sector_buffer[0x25] << 8) |
-                      ((uint32_t)sector_buffer[0x26] << 16) |
-                      ((uint32_t)sector_buffer[0x27] << 24);
-
-    root_cluster = sector_buffer[0x2C] |
-                   ((uint32_t)sector_buffer[0x2D] << 8) |
-                   ((uint32_t)sector_buffer[0x2E] << 16) |
-                   ((uint32_t)sector_buffer[0x2F] << 24);
+bool sd_write_multi_end(void) {
+    spi_transfer(TOKEN_STOP_TRAN);
+    spi_transfer(0xFF);
 
-    total_sectors = sector_buffer[0x20] |
-                    ((uint32_t)sector_buffer[0x21] << 8) |
-                    ((uint32_t)sector_buffer[0x22] << 16) |
-                    ((uint32_t)sector_buffer[0x23] << 24);
+    bool ok = sd_wait_not_busy();
+    spi_deselect();
+    return ok;
+}
 
-    fat_start_sector += reserved_sectors;
-    data_start_sector = fat_start_sector + (num_fats * sectors_per_fat);
+bool sd_read_multi_begin(uint32_t sector) {
+    uint32_t addr = (card_type == CT_SDHC) ? sector : (sector << 9);
 
+    if (sd_send_cmd(CMD18, addr) != 0) {
+        spi_deselect();
+        return false;
+    }
     return true;
 }
 
-static uint32_t cluster_to_sector(uint32_t cluster) {
-    return data_start_sector + ((cluster - 2) * sectors_per_cluster);
-}
-
-// Trouve ou crée le fichier CSV
-static bool fat32_find_or_create_file(void) {
-    // Pour simplifier, on utilise un fichier à cluster fixe
-    // Dans une implémentation complète, il faudrait parcourir la FAT
+bool sd_read_multi_next(uint8_t* buffer) {
+    uint8_t response;
+    uint16_t retry = 0;
 
-    // Lire le répertoire racine
-    uint32_t root_sector = cluster_to_sector(root_cluster);
+    while ((response = spi_transfer(0xFF)) == 0xFF) {
+        if (++retry > 10000) {
+            break;
+        }
+    }
 
-    if (!sd_read_sector(root_sector, sector_buffer)) {
+    if (response != TOKEN_START_BLOCK) {
+        // Clore le flux: sans CMD12 la carte continue d'envoyer des blocs
+        sd_read_multi_end();
         return false;
     }
 
-    // Chercher SD_TEST.CSV ou une entrée libre
-    bool found = false;
-    uint8_t free_entry = 255;
+    for (uint16_t i = 0; i < 512; i++) {
+        buffer[i] = spi_transfer(0xFF);
+    }
 
-    for (uint8_t i = 0; i < 16; i++) {  // 16 entrées par secteur
-        uint8_t* entry = &sector_buffer[i * 32];
+    // Ignorer CRC
+    spi_transfer(0xFF);
+    spi_transfer(0xFF);
+    return true;
+}
 
-        if (entry[0] == 0x00) {
-            // Fin du répertoire
-            if (free_entry == 255) free_entry = i;
-            break;
-        }
+bool sd_read_multi_end(void) {
+    // CMD12 envoyé sans désélection: la carte est encore en transfert
+    spi_transfer(0x40 | CMD12);
+    spi_transfer(0);
+    spi_transfer(0);
+    spi_transfer(0);
+    spi_transfer(0);
+    spi_transfer(0xFF);
+    spi_transfer(0xFF);  // Octet de bourrage après CMD12
 
-        if (entry[0] == 0xE5) {
-            // Entrée supprimée, peut être réutilisée
-            if (free_entry == 255) free_entry = i;
-            continue;
-        }
+    uint8_t response;
+    uint8_t retry = 0;
+    do {
+        response = spi_transfer(0xFF);
+    } while ((response & 0x80) && ++retry < 10);
 
-        // Comparer le nom (8.3 format: "SD_TEST CSV")
-        if (memcmp(entry, "SD_TEST CSV", 11) == 0) {
-            // Fichier trouvé!
-            found = true;
-            header_written = true;
+    bool ok = (response == 0) && sd_wait_not_busy();
+    spi_deselect();
+    return ok;
+}
 
-            // Récupérer le cluster de départ
-            uint32_t start_cluster = entry[0x1A] |
-                                     ((uint32_t)entry[0x1B] << 8) |
-                                     ((uint32_t)entry[0x14] << 16) |
-                                     ((uint32_t)entry[0x15] << 24);
+/**
+ * Efface une plage de secteurs (CMD32/CMD33/CMD38) et attend la fin
+ *
+ * Le délai suit le registre SD Status (ERASE_TIMEOUT pour ERASE_SIZE AU,
+ * plus ERASE_OFFSET); ERASE_TIMEOUT_MS à défaut.
+ */
+static bool sd_erase_block_range(uint32_t first, uint32_t count) {
+    uint32_t last = first + count - 1;
+    if (card_type != CT_SDHC) {
+        first <<= 9;
+        last <<= 9;
+    }
 
-            uint32_t file_size = entry[0x1C] |
-                                 ((uint32_t)entry[0x1D] << 8) |
-                                 ((uint32_t)entry[0x1E] << 16) |
-                                 ((uint32_t)entry[0x1F] << 24);
+    uint32_t timeout_ms = ERASE_TIMEOUT_MS;
+    if (card_status.valid && card_status.erase_timeout_s > 0) {
+        timeout_ms = ((uint32_t)card_status.erase_timeout_s + card_status.erase_offset_s) * 1000UL;
+    }
 
-            csv_next_sector = cluster_to_sector(start_cluster) + (file_size / 512);
-            csv_byte_offset = file_size % 512;
+    uint8_t r1 = sd_send_cmd(CMD32, first);
+    spi_deselect();
+    if (r1 != 0) {
+        return false;
+    }
+    r1 = sd_send_cmd(CMD33, last);
+    spi_deselect();
+    if (r1 != 0) {
+        return false;
+    }
+    if (sd_send_cmd(CMD38, 0) != 0) {
+        spi_deselect();
+        return false;
+    }
 
+    // Hors attente de programmation: l'effacement a ses propres statistiques
+    uint32_t start = millis();
+    bool ok = true;
+    while (spi_transfer(0xFF) == 0) {
+        if (millis() - start > timeout_ms) {
+            ok = false;
             break;
         }
     }
+    spi_deselect();
+    return ok;
+}
 
-    if (!found && free_entry < 16) {
-        // Créer le fichier
-        uint8_t* entry = &sector_buffer[free_entry * 32];
-
-        // Nom de fichier 8.3
-        memcpy(entry, "SD_TEST CSV", 11);
-        entry[0x0B] = 0x20;  // Attribut: archive
-
-        // Cluster de départ (utiliser un cluster libre simple)
-        // Pour simplifier, on utilise le cluster 3
-        uint32_t new_cluster = 3;
-        entry[0x14] = (new_cluster >> 16) & 0xFF;
-        entry[0x15] = (new_cluster >> 24) & 0xFF;
-        entry[0x1A] = new_cluster & 0xFF;
-        entry[0x1B] = (new_cluster >> 8) & 0xFF;
-
-        // Taille = 0
-        entry[0x1C] = 0;
-        entry[0x1D] = 0;
-        entry[0x1E] = 0;
-        entry[0x1F] = 0;
-
-        // Écrire le répertoire
-        if (!sd_write_sector(root_sector, sector_buffer)) {
-            return false;
+/**
+ * Efface des secteurs par morceaux alignés sur les AU
+ *
+ * Début et fin partiels forment leurs propres commandes; le cœur est
+ * découpé en ERASE_SIZE AU au plus, la taille couverte par le délai annoncé.
+ * Une carte qui efface par unités (ERASE_BLK_EN = 0) ne reçoit que les
+ * unités entières de la plage; sans CSD, rien n'est effacé sur SDSC.
+ */
+static bool sd_erase_range(uint32_t first, uint32_t count) {
+    uint32_t unit = card_id.valid ? card_id.erase_unit_sectors : (card_type == CT_SDHC) ? 1 : 0;
+    if (unit == 0) {
+        return true;
+    }
+    if (unit > 1) {
+        uint32_t end = (first + count) / unit * unit;
+        first = (first + unit - 1) / unit * unit;
+        if (end <= first) {
+            return true;
         }
+        count = end - first;
+    }
 
-        csv_next_sector = cluster_to_sector(new_cluster);
-        csv_byte_offset = 0;
-        header_written = false;
+    uint32_t au = card_status.au_sectors;
+    uint32_t max_chunk = (au > 0 && card_status.erase_size_au > 0) ? au * card_status.erase_size_au : count;
+    bool ok = true;
 
-        // Marquer le cluster comme utilisé dans la FAT
-        if (!sd_read_sector(fat_start_sector, sector_buffer)) {
-            return false;
+    while (count > 0 && ok) {
+        uint32_t chunk = count;
+        if (au > 0 && first % au != 0) {
+            chunk = au - first % au;            // Jusqu'à la frontière d'AU
+        } else if (au > 0 && count >= au) {
+            chunk = count - count % au;         // AU entières
         }
+        if (chunk > count) chunk = count;
+        if (chunk > max_chunk) chunk = max_chunk;
 
-        // Chaque entrée FAT32 fait 4 octets
-        uint32_t fat_offset = new_cluster * 4;
-        uint16_t fat_sector_offset = fat_offset % 512;
-
-        // Marquer comme fin de chaîne
-        sector_buffer[fat_sector_offset] = 0xFF;
-        sector_buffer[fat_sector_offset + 1] = 0xFF;
-        sector_buffer[fat_sector_offset + 2] = 0xFF;
-        sector_buffer[fat_sector_offset + 3] = 0x0F;
+        uint32_t start = micros();
+        ok = sd_erase_block_range(first, chunk);
+        uint32_t elapsed = micros() - start;
 
-        if (!sd_write_sector(fat_start_sector, sector_buffer)) {
-            return false;
+        fs_stats.erase_count++;
+        fs_stats.erase_total_us += elapsed;
+        if (elapsed > fs_stats.erase_max_us) {
+            fs_stats.erase_max_us = elapsed;
+        }
+        if (ok) {
+            fs_stats.erase_sectors += chunk;
+        } else {
+            fs_stats.erase_errors++;
         }
+
+        first += chunk;
+        count -= chunk;
     }
 
-    return found || (free_entry < 16);
+    return ok;
 }
 
-// =============================================================================
-// IMPLÉMENTATION API PUBLIQUE
-// =============================================================================
+/**
+ * Lit le registre SD Status (ACMD13, 64 octets) et en extrait AU, classe
+ * de vitesse et paramètres d'effacement
+ */
+static bool sd_read_status(void) {
+    // Taille d'AU (code 4 bits) en secteurs de 512 octets, 16 Ko à 64 Mo
+    static const uint32_t au_sectors_table[16] = {
+        0, 32, 64, 128, 256, 512, 1024, 2048,
+        4096, 8192, 16384, 24576, 32768, 49152, 65536, 131072
+    };
+    static const uint8_t speed_class_table[5] = {0, 2, 4, 6, 10};
+    uint8_t status[64];
+
+    memset(&card_status, 0, sizeof(card_status));
+
+    // Réponse R2: R1 suivi d'un second octet d'état
+    if (sd_send_cmd(0x80 | ACMD13, 0) != 0) {
+        spi_deselect();
+        return false;
+    }
+    spi_transfer(0xFF);
 
-bool sd_controller_init(void) {
-    spi_init();
-    current_spi_freq = SD_SPI_FREQUENCY;
-    sd_initialized = false;
-    sd_mounted = false;
-    card_type = CT_NONE;
-    header_written = false;
+    if (!sd_read_data(status, sizeof(status))) {
+        return false;
+    }
 
+    card_status.au_sectors = au_sectors_table[status[10] >> 4];
+    card_status.speed_class = (status[8] < 5) ? speed_class_table[status[8]] : 0;
+    card_status.erase_size_au = ((uint16_t)status[11] << 8) | status[12];
+    card_status.erase_timeout_s = status[13] >> 2;
+    card_status.erase_offset_s = status[13] & 0x03;
+    card_status.valid = true;
     return true;
 }
 
-sd_error_t sd_mount(uint32_t freq_hz) {
-    uint32_t start_time = micros();
-    uint8_t response;
-    uint16_t retry;
+// Lit un registre de 16 octets (CMD9 = CSD, CMD10 = CID)
+static bool sd_read_register(uint8_t cmd, uint8_t* reg) {
+    if (sd_send_cmd(cmd, 0) != 0) {
+        spi_deselect();
+        return false;
+    }
+    return sd_read_data(reg, 16);
+}
 
-    if (freq_hz > 0) {
-        current_spi_freq = freq_hz;
+/**
+ * Lit CID et CSD: identifiants, capacité réelle, vitesse et timings
+ * d'écriture annoncés
+ */
+static bool sd_read_card_id(void) {
+    // TRAN_SPEED: mantisse x10 et unité en kbit/s
+    static const uint8_t tran_value_table[16] = {
+        0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80
+    };
+    static const uint32_t tran_unit_table[4] = {100, 1000, 10000, 100000};
+    uint8_t cid[16];
+    uint8_t csd[16];
+
+    memset(&card_id, 0, sizeof(card_id));
+
+    if (!sd_read_register(CMD10, cid) || !sd_read_register(CMD9, csd)) {
+        return false;
     }
 
-    if (sd_mounted) {
-        sd_unmount();
+    card_id.manufacturer_id = cid[0];
+    card_id.oem_id[0] = cid[1];
+    card_id.oem_id[1] = cid[2];
+    memcpy(card_id.product, &cid[3], 5);
+    card_id.revision = cid[8];
+    card_id.serial = ((uint32_t)cid[9] << 24) | ((uint32_t)cid[10] << 16) |
+                     ((uint32_t)cid[11] << 8) | cid[12];
+    card_id.mfg_year = 2000 + (((cid[13] & 0x0F) << 4) | (cid[14] >> 4));
+    card_id.mfg_month = cid[14] & 0x0F;
+
+    if ((csd[0] >> 6) == 1) {
+        // CSD v2 (SDHC/SDXC): C_SIZE en unités de 512 Ko
+        uint32_t c_size = ((uint32_t)(csd[7] & 0x3F) << 16) | ((uint32_t)csd[8] << 8) | csd[9];
+        card_id.sectors = (c_size + 1) << 10;
+    } else {
+        // CSD v1 (SDSC)
+        uint32_t c_size = ((uint32_t)(csd[6] & 0x03) << 10) | ((uint32_t)csd[7] << 2) | (csd[8] >> 6);
+        uint8_t c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+        uint8_t read_bl_len = csd[5] & 0x0F;
+        card_id.sectors = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+    }
+
+    card_id.taac = csd[1];
+    card_id.nsac = csd[2];
+    card_id.tran_speed_khz = tran_unit_table[csd[3] & 0x03] * tran_value_table[(csd[3] >> 3) & 0x0F] / 10;
+    card_id.r2w_factor = (csd[12] >> 2) & 0x07;
+    card_id.write_bl_len = ((csd[12] & 0x03) << 2) | (csd[13] >> 6);
+
+    // ERASE_BLK_EN = 0 (SDSC): la carte efface par SECTOR_SIZE + 1 blocs d'écriture
+    if (csd[10] & 0x40) {
+        card_id.erase_unit_sectors = 1;
+    } else {
+        uint8_t sector_size = ((csd[10] & 0x3F) << 1) | (csd[11] >> 7);
+        uint8_t shift = (card_id.write_bl_len > 9) ? card_id.write_bl_len - 9 : 0;
+        card_id.erase_unit_sectors = (uint16_t)(sector_size + 1) << shift;
+    }
+    card_id.valid = true;
+
+    card_sectors = card_id.sectors;
+    return true;
+}
+
+// Premier profil de CARD_PROFILES correspondant au CID lu
+static const card_profile_t* card_profile_lookup(void) {
+    for (uint8_t i = 0; i < CARD_PROFILE_COUNT; i++) {
+        const card_profile_t* p = &CARD_PROFILES[i];
+        if (p->manufacturer_id != 0 && p->manufacturer_id != card_id.manufacturer_id) continue;
+        if (p->oem_id[0] != '\0' && strncmp(p->oem_id, card_id.oem_id, 2) != 0) continue;
+        if (p->product[0] != '\0' && strncmp(p->product, card_id.product, 5) != 0) continue;
+        return p;
     }
+    return nullptr;
+}
+
+/**
+ * Initialise la carte (CMD0, CMD8, ACMD41, CMD58) puis lit SD Status,
+ * CID et CSD; applique le profil d'une carte nouvellement insérée
+ */
+static sd_error_t sd_card_init(void) {
+    uint8_t response;
+    uint16_t retry;
 
     // Phase 1: Initialisation à basse vitesse
     uint32_t saved_freq = current_spi_freq;
@@ -486,7 +698,6 @@ sd_error_t sd_mount(uint32_t freq_hz) {
     if (response != R1_IDLE_STATE) {
         spi_deselect();
         current_spi_freq = saved_freq;
-        last_init_time_us = micros() - start_time;
         return ERR_SD_INIT_FAILED;
     }
 
@@ -503,7 +714,6 @@ sd_error_t sd_mount(uint32_t freq_hz) {
 
         if (ocr[2] != 0x01 || ocr[3] != 0xAA) {
             current_spi_freq = saved_freq;
-            last_init_time_us = micros() - start_time;
             return ERR_SD_CARD_TYPE_UNKNOWN;
         }
 
@@ -516,7 +726,6 @@ sd_error_t sd_mount(uint32_t freq_hz) {
         if (response != 0) {
             spi_deselect();
             current_spi_freq = saved_freq;
-            last_init_time_us = micros() - start_time;
             return ERR_SD_INIT_FAILED;
         }
 
@@ -541,7 +750,6 @@ sd_error_t sd_mount(uint32_t freq_hz) {
 
         if (response != 0) {
             current_spi_freq = saved_freq;
-            last_init_time_us = micros() - start_time;
             return ERR_SD_INIT_FAILED;
         }
 
@@ -549,7 +757,6 @@ sd_error_t sd_mount(uint32_t freq_hz) {
     } else {
         spi_deselect();
         current_spi_freq = saved_freq;
-        last_init_time_us = micros() - start_time;
         return ERR_SD_INIT_FAILED;
     }
 
@@ -559,7 +766,6 @@ sd_error_t sd_mount(uint32_t freq_hz) {
         spi_deselect();
         if (response != 0) {
             current_spi_freq = saved_freq;
-            last_init_time_us = micros() - start_time;
             return ERR_SD_INIT_FAILED;
         }
     }
@@ -568,57 +774,3280 @@ sd_error_t sd_mount(uint32_t freq_hz) {
     current_spi_freq = saved_freq;
     sd_initialized = true;
 
-    // Phase 2: Monter le système de fichiers FAT32
-    if (!fat32_read_bpb()) {
-        last_init_time_us = micros() - start_time;
-        return ERR_FAT_VOLUME_FAILED;
-    }
-
-    // Trouver ou créer le fichier CSV
-    if (!fat32_find_or_create_file()) {
-        last_init_time_us = micros() - start_time;
-        return ERR_FILE_OPEN_FAILED;
+    // Géométrie interne (AU); facultative, certaines cartes la refusent
+    sd_read_status();
+
+    // Nouvelle carte: appliquer son profil (le fallback SPI repart de là,
+    // la fréquence courante reste celle passée à sd_mount le cas échéant)
+    uint32_t previous_serial = card_id.valid ? card_id.serial : 0;
+    uint8_t previous_mid = card_id.manufacturer_id;
+    if (sd_read_card_id() &&
+        (card_id.serial != previous_serial || card_id.manufacturer_id != previous_mid)) {
+        card_profile = card_profile_lookup();
+        base_spi_freq = (card_profile != nullptr) ? card_profile->spi_freq_hz : SD_SPI_FREQUENCY;
+        flush_batch_lines = (card_profile != nullptr && card_profile->batch_lines > 0) ?
+                            card_profile->batch_lines : CSV_FLUSH_BATCH_LINES;
+        if (!spi_freq_forced) {
+            current_spi_freq = base_spi_freq;
+        }
     }
 
-    sd_mounted = true;
-    last_init_time_us = micros() - start_time;
     return ERR_NONE;
 }
 
-sd_error_t sd_unmount(void) {
-    sd_mounted = false;
-    spi_deselect();
-    return ERR_NONE;
+// =============================================================================
+// FONCTIONS FAT32 SIMPLIFIÉES
+// =============================================================================
+
+// Structure du BPB (BIOS Parameter Block)
+static uint16_t bytes_per_sector = 512;
+static uint16_t sectors_per_cluster = 1;     // Jusqu'à 256 (clusters exFAT de 128 Ko)
+static uint16_t reserved_sectors = 0;
+static uint8_t num_fats = 2;
+static uint32_t sectors_per_fat = 0;
+static uint32_t root_cluster = 2;
+static uint32_t fat_start_sector = 0;
+static uint32_t data_start_sector = 0;
+static uint32_t total_sectors = 0;
+static uint32_t volume_start_sector = 0;
+static uint32_t cluster_count = 0;
+static uint32_t fsinfo_sector = 0;          // 0 = absent ou invalide
+static bool volume_cached = false;          // Géométrie valide pour volume_card_serial
+static bool fat16 = false;                  // Entrées de 16 bits, racine en zone fixe
+static uint32_t root_dir_sector = 0;        // FAT16: premier secteur de la racine
+static uint16_t root_dir_sectors = 0;       // FAT16: taille de la racine (0 en FAT32)
+static bool exfat = false;                  // Bitmap d'allocation, journal sans chaîne FAT
+static uint32_t exfat_bitmap_sector = 0;    // exFAT: premier secteur de la bitmap (contiguë)
+static uint32_t volume_card_serial = 0;
+static uint32_t meta_dir_cluster = 0;       // Répertoire des opérations sd_meta_* (0 = non ouvert)
+
+// Emplacement d'une entrée de répertoire (secteur + index 0..15)
+typedef struct {
+    uint32_t sector;
+    uint8_t index;
+} dir_loc_t;
+
+// Entrée du fichier CSV, conservée entre les montages
+static dir_loc_t csv_dir_loc = {0, 0};
+static uint32_t csv_first_cluster = 0;
+static uint32_t csv_size_on_disk = 0;
+static uint32_t csv_alloc_sectors = 0;      // Secteurs couverts par la chaîne allouée
+static char csv_name83[12] = CSV_FILENAME_83;   // Fichier actif (rotation)
+
+static uint32_t get_le32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
-bool sd_is_mounted(void) {
-    return sd_mounted;
+static void put_le32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
 }
 
-sd_error_t sd_write_csv_line(uint32_t cycle, const cycle_result_t* result, uint32_t timestamp_ms) {
-    if (!sd_mounted) {
-        return ERR_SD_MOUNT_FAILED;
-    }
+static uint16_t get_le16(const uint8_t* p) {
+    return p[0] | ((uint16_t)p[1] << 8);
+}
 
-    uint32_t start_time = micros();
+static void put_le16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
 
-    // Préparer la ligne
-    char line[CSV_LINE_MAX_SIZE];
-    int len;
+// Entrées par secteur de FAT: 256 en FAT16, 128 en FAT32
+static uint16_t fat_entries_per_sector(void) {
+    return fat16 ? 256 : 128;
+}
 
-    // Écrire l'en-tête si c'est le premier write
-    if (!header_written) {
-        len = snprintf(line, sizeof(line), "%s", CSV_HEADER);
-        header_written = true;
-    } else {
-        line[0] = '\0';
-        len = 0;
+/**
+ * Entrée i d'un secteur de FAT, au format FAT32 quel que soit le type:
+ * les fins de chaîne FAT16 (>= 0xFFF8) deviennent FAT32_EOC
+ */
+static uint32_t fat_entry_read(const uint8_t* fat, uint16_t i) {
+    if (fat16) {
+        uint16_t value = get_le16(&fat[i * 2]);
+        return (value >= 0xFFF8) ? FAT32_EOC : value;
     }
+    return get_le32(&fat[i * 4]) & 0x0FFFFFFF;
+}
 
-    // Ajouter la ligne de données
-    int data_len = snprintf(line + len, sizeof(line) - len,
-        "%lu,%lu,%s,%d,%lu,%lu,%lu,%lu,%lu\n",
-        timestamp_ms,
+static uint32_t cluster_to_sector(uint32_t cluster) {
+    return data_start_sector + ((cluster - 2) * sectors_per_cluster);
+}
+
+// Types de partition FAT16 (< 32 Mo, CHS, LBA), FAT32 (CHS, LBA) et exFAT
+static bool mbr_type_is_fat(uint8_t type) {
+    return type == 0x04 || type == 0x06 || type == 0x0E || type == 0x0B || type == 0x0C ||
+           (EXFAT_ENABLED && type == 0x07);
+}
+
+// Champs du BPB selon le type: taille de FAT et nombre de secteurs 16 bits
+// non nuls en FAT16, nuls en FAT32
+static uint32_t bpb_fat_size(const uint8_t* b) {
+    uint16_t fat_size16 = get_le16(&b[0x16]);
+    return fat_size16 ? fat_size16 : get_le32(&b[0x24]);
+}
+
+static uint32_t bpb_total_sectors(const uint8_t* b) {
+    uint16_t total16 = get_le16(&b[0x13]);
+    return total16 ? total16 : get_le32(&b[0x20]);
+}
+
+/**
+ * Vérifie qu'un secteur est un secteur de boot FAT16 ou FAT32 exploitable
+ *
+ * Un MBR porte aussi 0x55AA: le saut x86 et la cohérence du BPB les
+ * distinguent (secteurs de 512 octets, clusters en puissance de 2, racine
+ * fixe en FAT16 ou cluster racine en FAT32, volume plus grand que ses
+ * métadonnées).
+ */
+static bool bpb_is_valid(const uint8_t* b) {
+    if (b[510] != 0x55 || b[511] != 0xAA) {
+        return false;
+    }
+    if (!(b[0] == 0xEB && b[2] == 0x90) && b[0] != 0xE9) {
+        return false;
+    }
+
+    uint8_t spc = b[0x0D];
+    uint16_t reserved = get_le16(&b[0x0E]);
+    uint8_t fats = b[0x10];
+    uint16_t root_entries = get_le16(&b[0x11]);
+    uint32_t fat_size = bpb_fat_size(b);
+    uint32_t total = bpb_total_sectors(b);
+    bool is_fat16 = get_le16(&b[0x16]) != 0;
+
+    if (is_fat16 ? root_entries == 0 : (root_entries != 0 || get_le32(&b[0x2C]) < 2)) {
+        return false;
+    }
+
+    return get_le16(&b[0x0B]) == 512 && spc != 0 && (spc & (spc - 1)) == 0 &&
+           reserved > 0 && fats >= 1 && fats <= 2 && fat_size > 0 &&
+           total > reserved + fats * fat_size + (root_entries * 32UL + 511) / 512 + spc;
+}
+
+/**
+ * Vérifie qu'un secteur est un secteur de boot exFAT exploitable
+ *
+ * Nom "EXFAT   ", ancien BPB à zéro, secteurs de 512 octets, FAT et tas
+ * de clusters cohérents, tas de clusters adressable en LBA 32 bits (le
+ * volume peut être plus long). La somme de contrôle de la région de boot
+ * n'est pas vérifiée.
+ */
+static bool exfat_boot_is_valid(const uint8_t* b) {
+    if (!EXFAT_ENABLED || b[510] != 0x55 || b[511] != 0xAA || memcmp(&b[3], "EXFAT   ", 8) != 0) {
+        return false;
+    }
+    for (uint8_t i = 11; i < 64; i++) {
+        if (b[i] != 0) {
+            return false;
+        }
+    }
+
+    uint32_t fat_offset = get_le32(&b[0x50]);
+    uint32_t fat_length = get_le32(&b[0x54]);
+    uint32_t heap_offset = get_le32(&b[0x58]);
+    uint32_t clusters = get_le32(&b[0x5C]);
+    uint32_t root = get_le32(&b[0x60]);
+    uint8_t spc_shift = b[0x6D];
+    uint8_t fats = b[0x6E];
+    uint64_t volume_length = get_le32(&b[0x48]) | ((uint64_t)get_le32(&b[0x4C]) << 32);
+    uint64_t heap_end = heap_offset + ((uint64_t)clusters << spc_shift);
+
+    return b[0x6C] == 9 && spc_shift <= 8 && fats >= 1 && fats <= 2 &&
+           fat_offset >= 24 && fat_length > 0 &&
+           (uint64_t)fat_length * 128 >= (uint64_t)clusters + 2 &&
+           heap_offset >= fat_offset + fats * fat_length &&
+           clusters > 0 && root >= 2 && root <= clusters + 1 &&
+           heap_end <= volume_length && heap_end <= 0xFFFFFFFFUL;
+}
+
+// Géométrie d'un volume FAT16/FAT32 (secteur de boot dans sector_buffer)
+static bool fat_read_geometry(uint32_t start) {
+    bytes_per_sector = get_le16(&sector_buffer[0x0B]);
+    sectors_per_cluster = sector_buffer[0x0D];
+    reserved_sectors = get_le16(&sector_buffer[0x0E]);
+    num_fats = sector_buffer[0x10];
+    sectors_per_fat = bpb_fat_size(sector_buffer);
+    total_sectors = bpb_total_sectors(sector_buffer);
+    root_dir_sectors = (get_le16(&sector_buffer[0x11]) * 32UL + 511) / 512;
+
+    volume_start_sector = start;
+    fat_start_sector = start + reserved_sectors;
+    root_dir_sector = fat_start_sector + (num_fats * sectors_per_fat);
+    data_start_sector = root_dir_sector + root_dir_sectors;
+    cluster_count = (total_sectors - (data_start_sector - volume_start_sector)) / sectors_per_cluster;
+
+    // Type lu dans le BPB (racine fixe = FAT16), comme le font la plupart
+    // des systèmes: de petits volumes FAT32 existent. FAT12 non géré, et
+    // une FAT16 ne peut pas adresser plus de 65524 clusters.
+    fat16 = root_dir_sectors > 0;
+    if (fat16 ? (cluster_count < 4085 || cluster_count >= 65525) : cluster_count == 0) {
+        return false;
+    }
+
+    // La FAT doit couvrir tous les clusters et la racine FAT32 en faire partie
+    if ((uint64_t)sectors_per_fat * fat_entries_per_sector() < cluster_count + 2) {
+        return false;
+    }
+
+    if (fat16) {
+        root_cluster = 0;
+        fsinfo_sector = 0;
+    } else {
+        root_cluster = get_le32(&sector_buffer[0x2C]);
+        if (root_cluster > cluster_count + 1) {
+            return false;
+        }
+        uint16_t fsinfo = get_le16(&sector_buffer[0x30]);
+        fsinfo_sector = (fsinfo > 0 && fsinfo < reserved_sectors) ? volume_start_sector + fsinfo : 0;
+    }
+    return true;
+}
+
+/**
+ * Géométrie d'un volume exFAT (secteur de boot dans sector_buffer)
+ *
+ * Seule la FAT active est utilisée. La bitmap d'allocation est cherchée
+ * dans le premier cluster de la racine, où la placent les formateurs.
+ * Pas de zone réservée ni de FSInfo: checkpoints et index de rotation
+ * sont inactifs sur ce type de volume.
+ */
+static bool exfat_read_boot(uint32_t start) {
+    bool second_fat = sector_buffer[0x6E] == 2 && (sector_buffer[0x6A] & 0x01);
+
+    bytes_per_sector = 512;
+    sectors_per_cluster = 1 << sector_buffer[0x6D];
+    reserved_sectors = 0;
+    num_fats = 1;
+    sectors_per_fat = get_le32(&sector_buffer[0x54]);
+    total_sectors = (get_le32(&sector_buffer[0x4C]) != 0) ? 0xFFFFFFFFUL : get_le32(&sector_buffer[0x48]);  // Plafonnée en LBA 32 bits
+    root_dir_sectors = 0;
+    fsinfo_sector = 0;
+
+    volume_start_sector = start;
+    fat_start_sector = start + get_le32(&sector_buffer[0x50]) + (second_fat ? sectors_per_fat : 0);
+    data_start_sector = start + get_le32(&sector_buffer[0x58]);
+    cluster_count = get_le32(&sector_buffer[0x5C]);
+    root_cluster = get_le32(&sector_buffer[0x60]);
+
+    exfat_bitmap_sector = 0;
+    for (uint16_t s = 0; s < sectors_per_cluster; s++) {
+        fs_stats.volume_detect_reads++;
+        if (!sd_read_sector(cluster_to_sector(root_cluster) + s, sector_buffer)) {
+            return false;
+        }
+
+        for (uint8_t i = 0; i < 16; i++) {
+            const uint8_t* entry = &sector_buffer[i * 32];
+            if (entry[0] == 0x00) {
+                return false;  // Fin de la racine sans bitmap
+            }
+            // Bitmap de la FAT active, couvrant tous les clusters
+            if (entry[0] == 0x81 && (entry[1] & 0x01) == (second_fat ? 1 : 0)) {
+                uint32_t first = get_le32(&entry[20]);
+                if (first < 2 || first > cluster_count + 1 ||
+                    (get_le32(&entry[24]) < (cluster_count + 7) / 8 && get_le32(&entry[28]) == 0)) {
+                    return false;
+                }
+                exfat_bitmap_sector = cluster_to_sector(first);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Localise et lit le volume FAT16, FAT32 ou exFAT
+ *
+ * Secteur 0 accepté comme secteur de boot s'il en est un (carte sans
+ * partition), sinon lu comme MBR: les quatre entrées sont parcourues et la
+ * première de type FAT ou exFAT dont le secteur de boot est valide est retenue.
+ * Volume et géométrie restent en RAM: tant que le numéro de série de la
+ * carte ne change pas, les montages suivants ne relisent rien.
+ */
+static bool fat32_read_bpb(void) {
+    if (volume_cached && card_id.valid && card_id.serial == volume_card_serial) {
+        fs_stats.volume_detect_reads = 0;
+        return true;
+    }
+    volume_cached = false;
+    meta_dir_cluster = 0;  // Cluster de l'ancienne carte: à rouvrir
+
+    fs_stats.volume_detect_reads = 1;
+    if (!sd_read_sector(0, sector_buffer)) {
+        return false;
+    }
+
+    uint32_t start = 0;
+    uint8_t part_type = 0;
+
+    if (!bpb_is_valid(sector_buffer) && !exfat_boot_is_valid(sector_buffer)) {
+        if (sector_buffer[510] != 0x55 || sector_buffer[511] != 0xAA) {
+            return false;
+        }
+
+        // Table copiée: sector_buffer est réutilisé pour lire chaque candidat
+        uint32_t starts[4];
+        uint8_t types[4];
+        for (uint8_t i = 0; i < 4; i++) {
+            const uint8_t* entry = &sector_buffer[0x1BE + i * 16];
+            types[i] = entry[4];
+            starts[i] = get_le32(&entry[8]);
+        }
+
+        for (uint8_t i = 0; i < 4 && part_type == 0; i++) {
+            if (!mbr_type_is_fat(types[i]) || starts[i] == 0) {
+                continue;
+            }
+            fs_stats.volume_detect_reads++;
+            if (!sd_read_sector(starts[i], sector_buffer)) {
+                return false;
+            }
+            if (bpb_is_valid(sector_buffer) || exfat_boot_is_valid(sector_buffer)) {
+                start = starts[i];
+                part_type = types[i];
+            }
+        }
+
+        if (part_type == 0) {
+            return false;
+        }
+    }
+
+    // Lire BPB
+    exfat = exfat_boot_is_valid(sector_buffer);
+    fat16 = false;
+    if (exfat ? !exfat_read_boot(start) : !fat_read_geometry(start)) {
+        return false;
+    }
+
+    fs_stats.volume_start = start;
+    fs_stats.partition_type = part_type;
+    fs_stats.fat_bits = exfat ? 0 : (fat16 ? 16 : 32);
+    volume_cached = card_id.valid;
+    volume_card_serial = card_id.serial;
+    return true;
+}
+
+// =============================================================================
+// FAT - CHAÎNES DE CLUSTERS ET ALLOCATION
+// =============================================================================
+
+// Secteurs de FAT en cache (index relatif au début de la FAT #1)
+typedef struct {
+    uint32_t index;
+    bool valid;
+    bool dirty;
+    uint8_t data[512];
+} fat_cache_entry_t;
+
+static fat_cache_entry_t fat_cache[FAT_CACHE_ENTRIES];
+static uint8_t fat_cache_victim = 0;        // Prochaine entrée à évincer
+
+// Plage de secteurs écrits sur la FAT #1 mais pas encore sur les copies
+static uint32_t fat_mirror_lo = 0xFFFFFFFFUL;
+static uint32_t fat_mirror_hi = 0;
+
+static bool fat_write_copies(uint32_t index, const uint8_t* data, bool mirror) {
+    uint8_t copies = mirror ? num_fats : 1;
+
+    for (uint8_t f = 0; f < copies; f++) {
+        if (!sd_write_sector(fat_start_sector + f * sectors_per_fat + index, data)) {
+            return false;
+        }
+        fs_stats.fat_writes++;
+    }
+
+    if (!mirror && num_fats > 1) {
+        if (index < fat_mirror_lo) fat_mirror_lo = index;
+        if (index > fat_mirror_hi) fat_mirror_hi = index;
+    }
+    return true;
+}
+
+static bool fat_cache_write_back(fat_cache_entry_t* entry) {
+    if (!entry->valid || !entry->dirty) {
+        return true;
+    }
+    if (!fat_write_copies(entry->index, entry->data, !FAT_MIRROR_DEFERRED)) {
+        return false;
+    }
+    entry->dirty = false;
+    return true;
+}
+
+// Secteur de FAT en cache s'il y est, sans lecture
+static const uint8_t* fat_cache_peek(uint32_t index) {
+    for (uint8_t e = 0; e < FAT_CACHE_ENTRIES; e++) {
+        if (fat_cache[e].valid && fat_cache[e].index == index) {
+            return fat_cache[e].data;
+        }
+    }
+    return nullptr;
+}
+
+// Charge un secteur de FAT dans le cache (éviction tournante)
+static fat_cache_entry_t* fat_cache_get(uint32_t index) {
+    for (uint8_t e = 0; e < FAT_CACHE_ENTRIES; e++) {
+        if (fat_cache[e].valid && fat_cache[e].index == index) {
+            fs_stats.fat_cache_hits++;
+            return &fat_cache[e];
+        }
+    }
+
+    fat_cache_entry_t* entry = &fat_cache[fat_cache_victim];
+    fat_cache_victim = (fat_cache_victim + 1) % FAT_CACHE_ENTRIES;
+
+    if (!fat_cache_write_back(entry)) {
+        return nullptr;
+    }
+
+    entry->valid = false;
+    if (!sd_read_sector(fat_start_sector + index, entry->data)) {
+        return nullptr;
+    }
+    fs_stats.fat_cache_misses++;
+
+    entry->index = index;
+    entry->valid = true;
+    return entry;
+}
+
+// Écrit les secteurs de FAT modifiés (sur toutes les copies sauf mode différé)
+static bool fat_cache_flush(void) {
+    for (uint8_t e = 0; e < FAT_CACHE_ENTRIES; e++) {
+        if (!fat_cache_write_back(&fat_cache[e])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Recopie sur les autres FAT les secteurs écrits en mode différé
+static bool fat_mirror_sync(void) {
+    while (fat_mirror_lo <= fat_mirror_hi) {
+        if (!sd_read_sector(fat_start_sector + fat_mirror_lo, sector_buffer)) {
+            return false;
+        }
+        for (uint8_t f = 1; f < num_fats; f++) {
+            if (!sd_write_sector(fat_start_sector + f * sectors_per_fat + fat_mirror_lo, sector_buffer)) {
+                return false;
+            }
+            fs_stats.fat_writes++;
+        }
+        fat_mirror_lo++;
+    }
+
+    fat_mirror_lo = 0xFFFFFFFFUL;
+    fat_mirror_hi = 0;
+    return true;
+}
+
+static void fat_cache_invalidate(void) {
+    for (uint8_t e = 0; e < FAT_CACHE_ENTRIES; e++) {
+        fat_cache[e].valid = false;
+        fat_cache[e].dirty = false;
+    }
+    fat_mirror_lo = 0xFFFFFFFFUL;
+    fat_mirror_hi = 0;
+}
+
+// Lit l'entrée FAT d'un cluster (cluster suivant, 0 = libre, >= FAT32_EOC = fin)
+static bool fat_get(uint32_t cluster, uint32_t* value) {
+    uint16_t per_sector = fat_entries_per_sector();
+    fat_cache_entry_t* entry = fat_cache_get(cluster / per_sector);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    *value = fat_entry_read(entry->data, cluster % per_sector);
+    return true;
+}
+
+// Modifie l'entrée FAT d'un cluster en cache (FAT32: les 4 bits hauts
+// réservés sont conservés; FAT16: FAT32_EOC devient 0xFFFF)
+static bool fat_set(uint32_t cluster, uint32_t value) {
+    uint16_t per_sector = fat_entries_per_sector();
+    fat_cache_entry_t* entry = fat_cache_get(cluster / per_sector);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    if (fat16) {
+        put_le16(&entry->data[(cluster % per_sector) * 2],
+                 (value >= FAT32_EOC_MIN) ? 0xFFFF : (uint16_t)value);
+    } else {
+        uint8_t* p = &entry->data[(cluster % per_sector) * 4];
+        put_le32(p, (get_le32(p) & 0xF0000000) | (value & 0x0FFFFFFF));
+    }
+    entry->dirty = true;
+    return true;
+}
+
+// =============================================================================
+// FSINFO ET CACHE DES CLUSTERS LIBRES
+// =============================================================================
+
+static uint32_t fsinfo_free_count = FSINFO_UNKNOWN;
+static uint32_t fsinfo_next_free = FSINFO_UNKNOWN;
+static bool fsinfo_dirty = false;
+
+// Bitmap des clusters libres d'une fenêtre de la FAT (bit à 1 = libre)
+static uint8_t free_bitmap[FREE_BITMAP_BYTES];
+static uint32_t free_bitmap_base = 0;       // Premier cluster couvert
+static bool free_bitmap_valid = false;
+
+#define FREE_BITMAP_CLUSTERS    ((uint32_t)FREE_BITMAP_BYTES * 8)
+
+// Fenêtre alignée par masque et rechargée par secteurs de FAT entiers
+// (256 entrées en FAT16, 128 en FAT32)
+static_assert(FREE_BITMAP_BYTES % 32 == 0 && (FREE_BITMAP_BYTES & (FREE_BITMAP_BYTES - 1)) == 0,
+              "FREE_BITMAP_BYTES: puissance de 2, multiple de 32");
+
+// Lit les compteurs du secteur FSInfo désigné par le BPB
+static void fsinfo_load(void) {
+    fsinfo_free_count = FSINFO_UNKNOWN;
+    fsinfo_next_free = FSINFO_UNKNOWN;
+    fsinfo_dirty = false;
+
+    if (fsinfo_sector == 0 || !sd_read_sector(fsinfo_sector, sector_buffer)) {
+        fsinfo_sector = 0;
+        return;
+    }
+
+    if (get_le32(&sector_buffer[0]) != FSINFO_LEAD_SIG ||
+        get_le32(&sector_buffer[484]) != FSINFO_STRUCT_SIG ||
+        get_le32(&sector_buffer[508]) != FSINFO_TRAIL_SIG) {
+        fsinfo_sector = 0;
+        return;
+    }
+
+    fsinfo_free_count = get_le32(&sector_buffer[488]);
+    fsinfo_next_free = get_le32(&sector_buffer[492]);
+
+    // Valeurs incohérentes: traitées comme inconnues
+    if (fsinfo_free_count > cluster_count) {
+        fsinfo_free_count = FSINFO_UNKNOWN;
+    }
+    if (fsinfo_next_free < 2 || fsinfo_next_free > cluster_count + 1) {
+        fsinfo_next_free = FSINFO_UNKNOWN;
+    }
+}
+
+// Écrit les compteurs FSInfo s'ils ont changé depuis le montage
+static bool fsinfo_flush(void) {
+    if (!fsinfo_dirty || fsinfo_sector == 0) {
+        return true;
+    }
+
+    if (!sd_read_sector(fsinfo_sector, sector_buffer)) {
+        return false;
+    }
+    put_le32(&sector_buffer[488], fsinfo_free_count);
+    put_le32(&sector_buffer[492], fsinfo_next_free);
+    if (!sd_write_sector(fsinfo_sector, sector_buffer)) {
+        return false;
+    }
+
+    fsinfo_dirty = false;
+    return true;
+}
+
+// exFAT: secteur de la bitmap d'allocation et bit d'un cluster (1 = occupé)
+static uint32_t exfat_bitmap_lba(uint32_t cluster) {
+    return exfat_bitmap_sector + (cluster - 2) / 4096;
+}
+
+static uint16_t exfat_bitmap_bit(uint32_t cluster) {
+    return (cluster - 2) % 4096;
+}
+
+// exFAT: remplit la fenêtre depuis la bitmap d'allocation (bits inversés)
+static bool exfat_free_bitmap_load(uint32_t base) {
+    uint32_t last_cluster = cluster_count + 1;
+    uint32_t loaded = 0;
+
+    for (uint32_t c = (base < 2) ? 2 : base; c < base + FREE_BITMAP_CLUSTERS && c <= last_cluster; c++) {
+        if (loaded != exfat_bitmap_lba(c)) {
+            loaded = exfat_bitmap_lba(c);
+            if (!sd_read_sector(loaded, sector_buffer)) {
+                return false;
+            }
+            fs_stats.alloc_fat_reads++;
+        }
+
+        uint16_t bit = exfat_bitmap_bit(c);
+        if (!((sector_buffer[bit / 8] >> (bit % 8)) & 1)) {
+            free_bitmap[(c - base) / 8] |= (1 << ((c - base) % 8));
+        }
+    }
+    return true;
+}
+
+/**
+ * exFAT: marque un cluster occupé dans la bitmap d'allocation
+ *
+ * @return 1 si marqué, 0 s'il l'était déjà (fenêtre périmée), -1 si erreur
+ */
+static int8_t exfat_bitmap_set(uint32_t cluster) {
+    uint32_t lba = exfat_bitmap_lba(cluster);
+    uint16_t bit = exfat_bitmap_bit(cluster);
+
+    if (!sd_read_sector(lba, sector_buffer)) {
+        return -1;
+    }
+    if ((sector_buffer[bit / 8] >> (bit % 8)) & 1) {
+        return 0;
+    }
+    sector_buffer[bit / 8] |= (1 << (bit % 8));
+    return sd_write_sector(lba, sector_buffer) ? 1 : -1;
+}
+
+// Remplit la bitmap pour la fenêtre contenant cluster (alignée sur un secteur de FAT)
+static bool free_bitmap_load(uint32_t cluster) {
+    uint32_t base = cluster & ~(FREE_BITMAP_CLUSTERS - 1);
+    uint32_t last_cluster = cluster_count + 1;
+    uint16_t per_sector = fat_entries_per_sector();
+
+    memset(free_bitmap, 0, sizeof(free_bitmap));
+    free_bitmap_valid = false;
+
+    if (exfat) {
+        if (!exfat_free_bitmap_load(base)) {
+            return false;
+        }
+        free_bitmap_base = base;
+        free_bitmap_valid = true;
+        return true;
+    }
+
+    for (uint32_t c = base; c < base + FREE_BITMAP_CLUSTERS && c <= last_cluster; c += per_sector) {
+        // Un secteur en cache peut être plus récent que la carte
+        const uint8_t* fat = fat_cache_peek(c / per_sector);
+        if (fat == nullptr) {
+            if (!sd_read_sector(fat_start_sector + c / per_sector, sector_buffer)) {
+                return false;
+            }
+            fs_stats.alloc_fat_reads++;
+            fat = sector_buffer;
+        }
+
+        for (uint16_t i = 0; i < per_sector && c + i <= last_cluster; i++) {
+            if (c + i >= 2 && fat_entry_read(fat, i) == 0) {
+                uint32_t bit = c + i - base;
+                free_bitmap[bit / 8] |= (1 << (bit % 8));
+            }
+        }
+    }
+
+    free_bitmap_base = base;
+    free_bitmap_valid = true;
+    return true;
+}
+
+static bool free_bitmap_covers(uint32_t cluster) {
+    return free_bitmap_valid && cluster >= free_bitmap_base &&
+           cluster < free_bitmap_base + FREE_BITMAP_CLUSTERS;
+}
+
+// Marque un cluster occupé dans la bitmap si la fenêtre le couvre
+static void free_bitmap_clear(uint32_t cluster) {
+    if (free_bitmap_covers(cluster)) {
+        uint32_t bit = cluster - free_bitmap_base;
+        free_bitmap[bit / 8] &= ~(1 << (bit % 8));
+    }
+}
+
+static bool fat_cluster_is_free(uint32_t cluster, bool* is_free) {
+    if (cluster < 2 || cluster > cluster_count + 1) {
+        *is_free = false;
+        return true;
+    }
+
+    if (!free_bitmap_covers(cluster) && !free_bitmap_load(cluster)) {
+        return false;
+    }
+
+    uint32_t bit = cluster - free_bitmap_base;
+    *is_free = (free_bitmap[bit / 8] >> (bit % 8)) & 1;
+    return true;
+}
+
+static void alloc_record(uint32_t start_time) {
+    uint32_t elapsed = micros() - start_time;
+    fs_stats.alloc_count++;
+    fs_stats.alloc_total_us += elapsed;
+    if (elapsed > fs_stats.alloc_max_us) {
+        fs_stats.alloc_max_us = elapsed;
+    }
+}
+
+/**
+ * Alloue un cluster libre, marqué fin de chaîne, et le chaîne à prev_cluster
+ *
+ * La recherche part de hint (ou de l'indice next-free de FSInfo) et
+ * s'appuie sur la bitmap: une lecture de FAT par fenêtre de
+ * FREE_BITMAP_CLUSTERS clusters au lieu d'un parcours depuis le début.
+ * FSInfo n'est mis à jour qu'en RAM, écrit au démontage. Sur exFAT, le
+ * cluster est marqué dans la bitmap d'allocation, sans chaîne FAT.
+ *
+ * @param prev_cluster Dernier cluster de la chaîne à prolonger (0 = nouvelle chaîne)
+ * @param hint Cluster souhaité (0 = indice FSInfo)
+ * @return Cluster alloué, 0 si volume plein ou erreur
+ */
+static uint32_t fat_alloc_cluster(uint32_t prev_cluster, uint32_t hint) {
+    uint32_t start_time = micros();
+    uint32_t last_cluster = cluster_count + 1;
+    uint32_t cluster = 0;
+
+    if (fsinfo_free_count == 0) {
+        return 0;  // Volume plein selon FSInfo
+    }
+
+    if (hint < 2 || hint > last_cluster) {
+        hint = (fsinfo_next_free != FSINFO_UNKNOWN) ? fsinfo_next_free : 2;
+    }
+
+    // Fenêtres successives depuis hint, avec retour au début du volume
+    uint32_t candidate = hint;
+    uint32_t windows = cluster_count / FREE_BITMAP_CLUSTERS + 2;
+
+    while (windows-- > 0 && cluster == 0) {
+        if (!free_bitmap_covers(candidate) && !free_bitmap_load(candidate)) {
+            return 0;
+        }
+
+        uint32_t window_end = free_bitmap_base + FREE_BITMAP_CLUSTERS;
+        for (; candidate < window_end && candidate <= last_cluster; candidate++) {
+            uint32_t bit = candidate - free_bitmap_base;
+            if ((free_bitmap[bit / 8] >> (bit % 8)) & 1) {
+                cluster = candidate;
+                break;
+            }
+        }
+
+        if (cluster == 0) {
+            candidate = (window_end > last_cluster) ? 2 : window_end;
+        }
+    }
+
+    if (cluster == 0) {
+        return 0;
+    }
+
+    if (exfat) {
+        // Bitmap d'allocation seule: le fichier contigu n'a pas de chaîne FAT
+        int8_t marked = exfat_bitmap_set(cluster);
+        if (marked < 0) {
+            return 0;
+        }
+        if (marked == 0) {
+            free_bitmap_valid = false;
+            return fat_alloc_cluster(prev_cluster, cluster + 1);
+        }
+        free_bitmap_clear(cluster);
+    } else {
+        // Revérifier dans la FAT: la bitmap peut dater d'un montage précédent
+        uint32_t value;
+
+        if (!fat_get(cluster, &value)) {
+            return 0;
+        }
+        if (value != 0) {
+            // Fenêtre périmée: la recharger et reprendre la recherche
+            free_bitmap_valid = false;
+            return fat_alloc_cluster(prev_cluster, cluster + 1);
+        }
+
+        if (!fat_set(cluster, FAT32_EOC)) {
+            return 0;
+        }
+        free_bitmap_clear(cluster);
+
+        if (prev_cluster != 0 && !fat_set(prev_cluster, cluster)) {
+            return 0;
+        }
+    }
+
+    if (fsinfo_free_count != FSINFO_UNKNOWN) {
+        fsinfo_free_count--;
+    }
+    fsinfo_next_free = (cluster < last_cluster) ? cluster + 1 : 2;
+    fsinfo_dirty = true;
+
+    alloc_record(start_time);
+    return cluster;
+}
+
+/**
+ * Libère toute une chaîne (fichier remplacé ou supprimé)
+ *
+ * @param erase Effacer aussi les données, une commande par suite de
+ *              clusters contigus (sans effet si ERASE_ENABLED = 0)
+ */
+static bool fat_free_chain(uint32_t cluster, bool erase) {
+    uint32_t freed = 0;
+    uint32_t run_first = 0, run_length = 0;
+
+    // Borne: une chaîne corrompue peut boucler
+    while (cluster >= 2 && cluster <= cluster_count + 1 && freed < cluster_count) {
+        uint32_t next;
+        if (!fat_get(cluster, &next) || !fat_set(cluster, 0)) {
+            return false;
+        }
+        if (free_bitmap_covers(cluster)) {
+            uint32_t bit = cluster - free_bitmap_base;
+            free_bitmap[bit / 8] |= (1 << (bit % 8));
+        }
+        freed++;
+
+        // Effacement indicatif: un échec ne bloque pas la libération
+        if (ERASE_ENABLED && erase) {
+            if (run_length > 0 && cluster != run_first + run_length) {
+                sd_erase_range(cluster_to_sector(run_first), run_length * sectors_per_cluster);
+                run_length = 0;
+            }
+            if (run_length == 0) {
+                run_first = cluster;
+            }
+            run_length++;
+        }
+        cluster = next;
+    }
+
+    if (run_length > 0) {
+        sd_erase_range(cluster_to_sector(run_first), run_length * sectors_per_cluster);
+    }
+
+    if (fsinfo_free_count != FSINFO_UNKNOWN) {
+        fsinfo_free_count += freed;
+    }
+    fsinfo_dirty = true;
+    return fat_cache_flush();
+}
+
+// =============================================================================
+// RÉPERTOIRES
+// =============================================================================
+
+// Curseur sur les secteurs d'un répertoire: chaîne de clusters, ou zone
+// fixe de la racine FAT16 (cluster 0)
+typedef struct {
+    uint32_t cluster;
+    uint32_t last_cluster;      // Dernier cluster parcouru (0 = zone fixe)
+    uint16_t index;             // Secteur dans le cluster ou dans la zone fixe
+    uint16_t clusters_scanned;
+    bool fixed;
+} dir_cursor_t;
+
+static void dir_cursor_init(dir_cursor_t* cursor, uint32_t dir_cluster) {
+    cursor->cluster = dir_cluster;
+    cursor->last_cluster = dir_cluster;
+    cursor->index = 0;
+    cursor->clusters_scanned = 0;
+    cursor->fixed = (dir_cluster == 0);
+}
+
+/**
+ * Secteur suivant du répertoire (DIR_MAX_CLUSTERS clusters au plus)
+ *
+ * @return 1 si un secteur suit, 0 en fin de répertoire, -1 si erreur de lecture FAT
+ */
+static int8_t dir_cursor_next(dir_cursor_t* cursor, uint32_t* sector) {
+    if (cursor->fixed) {
+        if (cursor->index >= root_dir_sectors) {
+            return 0;
+        }
+        *sector = root_dir_sector + cursor->index++;
+        return 1;
+    }
+
+    if (cursor->index == sectors_per_cluster) {
+        if (!fat_get(cursor->cluster, &cursor->cluster)) {
+            return -1;
+        }
+        cursor->index = 0;
+        cursor->clusters_scanned++;
+    }
+
+    if (cursor->cluster < 2 || cursor->cluster >= FAT32_EOC_MIN ||
+        cursor->clusters_scanned >= DIR_MAX_CLUSTERS) {
+        return 0;
+    }
+
+    cursor->last_cluster = cursor->cluster;
+    *sector = cluster_to_sector(cursor->cluster) + cursor->index++;
+    return 1;
+}
+
+/**
+ * Parcourt tout un répertoire à la recherche d'un nom 8.3
+ *
+ * S'arrête au marqueur de fin (0x00). Mémorise le premier emplacement libre
+ * (supprimé ou fin) et le dernier cluster de la chaîne pour l'extension.
+ *
+ * @param dir_cluster Premier cluster, 0 pour la racine FAT16
+ * @param found Emplacement de l'entrée trouvée (sector_buffer contient son secteur)
+ * @param free_slot Premier emplacement libre (sector = 0 si aucun)
+ * @param last_cluster Dernier cluster parcouru (0 pour la racine FAT16)
+ * @return 1 si trouvé, 0 sinon, -1 si erreur de lecture
+ */
+static int8_t dir_find(uint32_t dir_cluster, const char* name, dir_loc_t* found,
+                       dir_loc_t* free_slot, uint32_t* last_cluster) {
+    dir_cursor_t cursor;
+    uint32_t sector;
+    int8_t next;
+
+    dir_cursor_init(&cursor, dir_cluster);
+    free_slot->sector = 0;
+    *last_cluster = dir_cluster;
+
+    while ((next = dir_cursor_next(&cursor, &sector)) > 0) {
+        *last_cluster = cursor.last_cluster;
+
+        if (!sd_read_sector(sector, sector_buffer)) {
+            return -1;
+        }
+        fs_stats.dir_lookup_sectors++;
+
+        for (uint8_t i = 0; i < 16; i++) {
+            uint8_t* entry = &sector_buffer[i * 32];
+
+            if (entry[0] == 0x00 || entry[0] == 0xE5) {
+                if (free_slot->sector == 0) {
+                    free_slot->sector = sector;
+                    free_slot->index = i;
+                }
+                if (entry[0] == 0x00) return 0;  // Fin du répertoire
+                continue;
+            }
+
+            // Noms longs et label de volume
+            if (entry[0x0B] == 0x0F || (entry[0x0B] & 0x08)) continue;
+
+            if (memcmp(entry, name, 11) == 0) {
+                found->sector = sector;
+                found->index = i;
+                return 1;
+            }
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Ajoute un cluster vide à la chaîne d'un répertoire plein
+ *
+ * La racine FAT16 a une taille fixe: pleine, elle ne peut pas s'étendre.
+ *
+ * @param free_slot Première entrée du nouveau cluster
+ */
+static bool dir_extend(uint32_t last_cluster, dir_loc_t* free_slot) {
+    if (last_cluster < 2) {
+        return false;
+    }
+
+    uint32_t cluster = fat_alloc_cluster(last_cluster, last_cluster + 1);
+    if (cluster == 0 || !fat_cache_flush()) {
+        return false;
+    }
+
+    memset(sector_buffer, 0, 512);
+    for (uint16_t s = 0; s < sectors_per_cluster; s++) {
+        if (!sd_write_sector(cluster_to_sector(cluster) + s, sector_buffer)) {
+            return false;
+        }
+    }
+
+    free_slot->sector = cluster_to_sector(cluster);
+    free_slot->index = 0;
+    return true;
+}
+
+static uint32_t dir_entry_cluster(const uint8_t* entry) {
+    return entry[0x1A] | ((uint32_t)entry[0x1B] << 8) |
+           ((uint32_t)entry[0x14] << 16) | ((uint32_t)entry[0x15] << 24);
+}
+
+// Remplit une entrée de répertoire (dates à zéro)
+static void dir_fill_entry(uint8_t* entry, const char* name, uint8_t attr, uint32_t cluster, uint32_t size) {
+    memset(entry, 0, 32);
+
+    // Nom de fichier 8.3
+    memcpy(entry, name, 11);
+    entry[0x0B] = attr;
+
+    entry[0x14] = (cluster >> 16) & 0xFF;
+    entry[0x15] = (cluster >> 24) & 0xFF;
+    entry[0x1A] = cluster & 0xFF;
+    entry[0x1B] = (cluster >> 8) & 0xFF;
+    put_le32(&entry[0x1C], size);
+}
+
+// Écrit une entrée de fichier (attribut archive) à l'emplacement donné
+static bool dir_write_entry(const dir_loc_t* loc, const char* name, uint32_t cluster, uint32_t size) {
+    if (!sd_read_sector(loc->sector, sector_buffer)) {
+        return false;
+    }
+
+    dir_fill_entry(&sector_buffer[loc->index * 32], name, 0x20, cluster, size);
+    return sd_write_sector(loc->sector, sector_buffer);
+}
+
+// =============================================================================
+// RÉPERTOIRE EXFAT (JEU D'ENTRÉES FICHIER + FLUX + NOM)
+// =============================================================================
+
+#define EXFAT_ENTRY_FILE        0x85
+#define EXFAT_ENTRY_STREAM      0xC0
+#define EXFAT_ENTRY_NAME        0xC1
+#define EXFAT_ALLOC_POSSIBLE    0x01
+#define EXFAT_NO_FAT_CHAIN      0x02
+#define EXFAT_SET_SIZE          96      // Fichier, flux et un nom de 15 caractères au plus
+#define EXFAT_ENTRY_UNUSED      0x01    // Entrée libre qui n'est pas une fin de répertoire
+
+// Jeu d'entrées du fichier CSV gardé en RAM pour recalculer sa somme de
+// contrôle; csv_dir_loc désigne l'entrée flux (tailles), exfat_file_loc
+// l'entrée fichier (somme de contrôle)
+static uint8_t exfat_set[EXFAT_SET_SIZE];
+static dir_loc_t exfat_file_loc = {0, 0};
+static dir_loc_t exfat_end_loc = {0, 0};    // Fin de racine trop proche du bout de son secteur
+static bool exfat_contiguous = false;       // NoFatChain: clusters contigus sans FAT
+static uint32_t exfat_data_length = 0;      // DataLength écrite sur la carte
+
+static uint8_t ascii_upper(uint8_t c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+// Nom long "SD_TEST.CSV" d'un nom 8.3 "SD_TEST CSV" (longueur retournée)
+static uint8_t exfat_long_name(const char* name83, char* out) {
+    uint8_t len = 0;
+
+    for (uint8_t i = 0; i < 8 && name83[i] != ' '; i++) {
+        out[len++] = name83[i];
+    }
+    if (name83[8] != ' ') {
+        out[len++] = '.';
+        for (uint8_t i = 8; i < 11 && name83[i] != ' '; i++) {
+            out[len++] = name83[i];
+        }
+    }
+    return len;
+}
+
+// NameHash de l'entrée flux: nom en majuscules, UTF-16 (ASCII seulement)
+static uint16_t exfat_name_hash(const char* name, uint8_t len) {
+    uint16_t hash = 0;
+
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t bytes[2] = {ascii_upper(name[i]), 0};
+        for (uint8_t b = 0; b < 2; b++) {
+            hash = ((hash & 1) ? 0x8000 : 0) + (hash >> 1) + bytes[b];
+        }
+    }
+    return hash;
+}
+
+// SetChecksum: tous les octets du jeu sauf le champ lui-même (octets 2-3)
+static uint16_t exfat_set_checksum(const uint8_t* set, uint16_t len) {
+    uint16_t sum = 0;
+
+    for (uint16_t i = 0; i < len; i++) {
+        if (i == 2 || i == 3) {
+            continue;
+        }
+        sum = ((sum & 1) ? 0x8000 : 0) + (sum >> 1) + set[i];
+    }
+    return sum;
+}
+
+// Compare une entrée nom (UTF-16) au nom attendu, sans tenir compte de la casse
+static bool exfat_name_matches(const uint8_t* entry, const char* name, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+        uint16_t c = get_le16(&entry[2 + i * 2]);
+        if (c > 0x7F || ascii_upper((uint8_t)c) != ascii_upper(name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Cherche un fichier dans la racine exFAT
+ *
+ * Seuls les jeux fichier + flux + un nom sont candidats (noms de 15
+ * caractères au plus); un jeu dont la somme de contrôle est fausse est
+ * ignoré. Le jeu trouvé est copié dans exfat_set. Mémorise aussi trois
+ * entrées libres consécutives d'un même secteur pour une création; si elles
+ * sont prises au secteur suivant, exfat_end_loc désigne le marqueur de fin
+ * (0x00) qui les précède.
+ *
+ * @param stream_loc Emplacement de l'entrée flux du fichier trouvé
+ * @param free_slot Premier emplacement libre (sector = 0 si aucun)
+ * @return 1 si trouvé, 0 sinon, -1 si erreur de lecture
+ */
+static int8_t exfat_find(const char* name, uint8_t len, dir_loc_t* stream_loc, dir_loc_t* free_slot) {
+    uint16_t hash = exfat_name_hash(name, len);
+    dir_cursor_t cursor;
+    uint32_t sector;
+    int8_t next;
+    uint8_t pending = 0;        // Entrées secondaires restantes du jeu courant
+    bool candidate = false;
+
+    dir_cursor_init(&cursor, root_cluster);
+    free_slot->sector = 0;
+    exfat_end_loc.sector = 0;
+
+    while ((next = dir_cursor_next(&cursor, &sector)) > 0) {
+        uint8_t free_run = 0;
+
+        if (!sd_read_sector(sector, sector_buffer)) {
+            return -1;
+        }
+        fs_stats.dir_lookup_sectors++;
+
+        for (uint8_t i = 0; i < 16; i++) {
+            const uint8_t* entry = &sector_buffer[i * 32];
+            uint8_t type = entry[0];
+
+            // Après le marqueur de fin (0x00), toutes les entrées sont libres
+            if (type == 0x00 && free_slot->sector == 0) {
+                uint8_t start = i - free_run;
+                if (start + 3 <= 16) {
+                    free_slot->sector = sector;
+                    free_slot->index = start;
+                } else {
+                    exfat_end_loc.sector = sector;
+                    exfat_end_loc.index = i;
+                    if (dir_cursor_next(&cursor, &sector) > 0) {
+                        free_slot->sector = sector;
+                        free_slot->index = 0;
+                    }
+                }
+            }
+            if (type == 0x00) {
+                return 0;
+            }
+
+            // Entrée inutilisée (bit 7 à 0)
+            if (!(type & 0x80)) {
+                pending = 0;
+                if (free_slot->sector == 0 && ++free_run == 3) {
+                    free_slot->sector = sector;
+                    free_slot->index = i - 2;
+                }
+                continue;
+            }
+            free_run = 0;
+
+            if (type == EXFAT_ENTRY_FILE) {
+                pending = entry[1];
+                candidate = (pending == 2);
+                if (candidate) {
+                    memcpy(exfat_set, entry, 32);
+                    exfat_file_loc.sector = sector;
+                    exfat_file_loc.index = i;
+                }
+                continue;
+            }
+            if (pending == 0) {
+                continue;  // Bitmap, table de majuscules, label...
+            }
+
+            pending--;
+            if (!candidate) {
+                continue;
+            }
+
+            if (pending == 1) {
+                candidate = type == EXFAT_ENTRY_STREAM && entry[3] == len && get_le16(&entry[4]) == hash;
+                if (candidate) {
+                    memcpy(&exfat_set[32], entry, 32);
+                    stream_loc->sector = sector;
+                    stream_loc->index = i;
+                }
+            } else if (type == EXFAT_ENTRY_NAME && exfat_name_matches(entry, name, len)) {
+                memcpy(&exfat_set[64], entry, 32);
+                if (get_le16(&exfat_set[2]) == exfat_set_checksum(exfat_set, EXFAT_SET_SIZE)) {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Met à jour ValidDataLength (taille écrite) et DataLength (taille
+ * allouée) du fichier CSV, puis la somme de contrôle du jeu d'entrées
+ *
+ * Entrée flux et entrée fichier sont presque toujours dans le même
+ * secteur: une seule réécriture.
+ */
+static bool exfat_update_file_size(void) {
+    uint32_t size = csv_next_seq * 512 + csv_byte_offset;
+    uint32_t data_length = csv_alloc_sectors * 512;
+    uint8_t* stream = &exfat_set[32];
+
+    if ((size == csv_size_on_disk && data_length == exfat_data_length) || csv_dir_loc.sector == 0) {
+        return true;
+    }
+
+    put_le32(&stream[8], size);
+    put_le32(&stream[12], 0);
+    put_le32(&stream[24], data_length);
+    put_le32(&stream[28], 0);
+    put_le16(&exfat_set[2], exfat_set_checksum(exfat_set, EXFAT_SET_SIZE));
+
+    if (!sd_read_sector(csv_dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+    memcpy(&sector_buffer[csv_dir_loc.index * 32], stream, 32);
+    if (exfat_file_loc.sector == csv_dir_loc.sector) {
+        memcpy(&sector_buffer[exfat_file_loc.index * 32], exfat_set, 32);
+    }
+    if (!sd_write_sector(csv_dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+
+    if (exfat_file_loc.sector != csv_dir_loc.sector) {
+        if (!sd_read_sector(exfat_file_loc.sector, sector_buffer)) {
+            return false;
+        }
+        memcpy(&sector_buffer[exfat_file_loc.index * 32], exfat_set, 32);
+        if (!sd_write_sector(exfat_file_loc.sector, sector_buffer)) {
+            return false;
+        }
+    }
+
+    csv_size_on_disk = size;
+    exfat_data_length = data_length;
+    return true;
+}
+
+// =============================================================================
+// TABLE D'EXTENTS DU FICHIER CSV
+// =============================================================================
+
+// Suite de clusters physiquement contigus de la chaîne du fichier
+typedef struct {
+    uint32_t logical;       // Index du premier cluster dans le fichier
+    uint32_t cluster;       // Premier cluster sur la carte
+    uint32_t length;        // Nombre de clusters
+} log_extent_t;
+
+// L'extent 0 est conservé, puis les LOG_EXTENT_MAX-1 derniers: la fin du
+// fichier, seule zone écrite, reste toujours adressable
+static log_extent_t log_extents[LOG_EXTENT_MAX];
+static uint8_t log_extent_count = 0;
+
+// Ajoute un cluster en fin de table (prolonge le dernier extent si contigu)
+static void log_extent_push(uint32_t cluster) {
+    uint32_t logical = csv_alloc_sectors / sectors_per_cluster;
+
+    if (log_extent_count > 0) {
+        log_extent_t* last = &log_extents[log_extent_count - 1];
+        if (last->cluster + last->length == cluster) {
+            last->length++;
+            csv_alloc_sectors += sectors_per_cluster;
+            return;
+        }
+    }
+
+    if (log_extent_count == LOG_EXTENT_MAX) {
+        // Table pleine: oublier le plus ancien après l'extent 0
+        memmove(&log_extents[1], &log_extents[2], (LOG_EXTENT_MAX - 2) * sizeof(log_extent_t));
+        log_extent_count--;
+        fs_stats.log_extents_dropped++;
+    }
+
+    log_extents[log_extent_count].logical = logical;
+    log_extents[log_extent_count].cluster = cluster;
+    log_extents[log_extent_count].length = 1;
+    log_extent_count++;
+    fs_stats.log_extents++;
+    csv_alloc_sectors += sectors_per_cluster;
+}
+
+/**
+ * Parcourt une fois la chaîne FAT du fichier pour construire la table
+ *
+ * Une lecture de FAT par secteur de 128 ou 256 entrées grâce au cache; les
+ * recherches suivantes coûtent O(extents).
+ */
+static bool log_load_extents(uint32_t first_cluster) {
+    uint32_t cluster = first_cluster;
+    uint32_t limit = cluster_count;
+
+    log_extent_count = 0;
+    csv_alloc_sectors = 0;
+    fs_stats.log_extents = 0;
+    fs_stats.log_extents_dropped = 0;
+
+    while (cluster >= 2 && cluster <= cluster_count + 1 && limit-- > 0) {
+        log_extent_push(cluster);
+        if (!fat_get(cluster, &cluster)) {
+            return false;
+        }
+    }
+
+    return log_extent_count > 0;
+}
+
+// Secteur de la carte d'une séquence du journal, 0 si hors de la table
+static uint32_t log_lba(uint32_t sequence) {
+    uint32_t logical = sequence / sectors_per_cluster;
+
+    // La fin du fichier est la zone la plus consultée
+    for (int8_t e = log_extent_count - 1; e >= 0; e--) {
+        const log_extent_t* ext = &log_extents[e];
+        if (logical >= ext->logical && logical < ext->logical + ext->length) {
+            return cluster_to_sector(ext->cluster + (logical - ext->logical)) +
+                   sequence % sectors_per_cluster;
+        }
+        if (logical >= ext->logical + ext->length) {
+            break;  // Dans un extent oublié
+        }
+    }
+    return 0;
+}
+
+/**
+ * Premier cluster à partir de cluster dont le premier secteur débute une AU
+ * (cluster inchangé si la taille d'AU est inconnue)
+ */
+static uint32_t au_align_cluster(uint32_t cluster) {
+    uint32_t au = card_status.au_sectors;
+
+    if (cluster < 2 || cluster > cluster_count + 1) {
+        cluster = 2;
+    }
+    if (au == 0) {
+        return cluster;
+    }
+
+    uint32_t sector = cluster_to_sector(cluster);
+    uint32_t aligned = ((sector + au - 1) / au) * au;
+    uint32_t target = cluster + (aligned - sector + sectors_per_cluster - 1) / sectors_per_cluster;
+    return (target <= cluster_count + 1) ? target : cluster;
+}
+
+// Ajoute une mesure, en élargissant les tranches si le journal les dépasse
+static void latency_record(uint32_t sequence, uint32_t busy_us) {
+    while ((sequence >> latency_shift) >= LATENCY_MAP_BUCKETS) {
+        // Fusion deux à deux: la couverture double
+        for (uint8_t i = 0; i < LATENCY_MAP_BUCKETS / 2; i++) {
+            latency_bucket_t* a = &latency_map[2 * i];
+            latency_bucket_t* b = &latency_map[2 * i + 1];
+            uint32_t writes = (uint32_t)a->writes + b->writes;
+            uint32_t sum = a->busy_sum_us + b->busy_sum_us;
+            uint16_t max = (a->busy_max_us > b->busy_max_us) ? a->busy_max_us : b->busy_max_us;
+            if (writes > 0xFFFF) {
+                writes /= 2;
+                sum /= 2;
+            }
+            latency_map[i].writes = writes;
+            latency_map[i].busy_sum_us = sum;
+            latency_map[i].busy_max_us = max;
+        }
+        memset(&latency_map[LATENCY_MAP_BUCKETS / 2], 0, sizeof(latency_map) / 2);
+        latency_shift++;
+    }
+
+    latency_bucket_t* bucket = &latency_map[sequence >> latency_shift];
+    if (bucket->writes == 0xFFFF || bucket->busy_sum_us > 0xFFFFFFFFUL - busy_us) {
+        // Garde la moyenne
+        bucket->writes /= 2;
+        bucket->busy_sum_us /= 2;
+    }
+    bucket->writes++;
+    bucket->busy_sum_us += busy_us;
+    if (busy_us > bucket->busy_max_us) {
+        bucket->busy_max_us = (busy_us > 0xFFFF) ? 0xFFFF : busy_us;
+    }
+}
+
+// Médiane des moyennes des tranches écrites (0 si aucune)
+static uint32_t latency_median(void) {
+    uint32_t avgs[LATENCY_MAP_BUCKETS];
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < LATENCY_MAP_BUCKETS; i++) {
+        if (latency_map[i].writes == 0) continue;
+
+        // Tri par insertion: au plus LATENCY_MAP_BUCKETS valeurs
+        uint32_t avg = latency_map[i].busy_sum_us / latency_map[i].writes;
+        uint8_t j = n++;
+        while (j > 0 && avgs[j - 1] > avg) {
+            avgs[j] = avgs[j - 1];
+            j--;
+        }
+        avgs[j] = avg;
+    }
+
+    return (n > 0) ? avgs[n / 2] : 0;
+}
+
+static bool latency_is_slow(const latency_bucket_t* bucket, uint32_t median) {
+    return bucket->writes > 0 && median > 0 &&
+           bucket->busy_sum_us / bucket->writes > median * LATENCY_MAP_SLOW_FACTOR;
+}
+
+// Écrit le secteur de fin du journal et compte les changements d'AU
+static bool log_flush(void) {
+    if (!log_tail_dirty) {
+        return true;
+    }
+
+    uint32_t lba = log_lba(csv_next_seq);
+    uint32_t busy_start = busy_time_us;
+    if (lba == 0 || !sd_write_sector(lba, log_tail)) {
+        return false;
+    }
+    latency_record(csv_next_seq, busy_time_us - busy_start);
+
+    if (card_status.au_sectors > 0) {
+        uint32_t au = lba / card_status.au_sectors;
+        if (au == last_log_au) {
+            fs_stats.au_same_writes++;
+        } else if (last_log_au != 0xFFFFFFFFUL) {
+            fs_stats.au_crossings++;
+        }
+        last_log_au = au;
+    }
+
+    log_tail_dirty = false;
+    log_tail_lines = 0;
+    return true;
+}
+
+/**
+ * Prolonge la chaîne du fichier d'un cluster avant d'écrire au-delà
+ *
+ * Le cluster physiquement suivant est préféré pour limiter la
+ * fragmentation; à défaut un nouvel extent est ouvert. Sur exFAT, le
+ * fichier NoFatChain ne peut croître que dans le cluster suivant.
+ */
+static bool log_grow(void) {
+    uint32_t start_time = micros();
+    const log_extent_t* ext = &log_extents[log_extent_count - 1];
+    uint32_t last = ext->cluster + ext->length - 1;
+    uint32_t hint = last + 1;
+    bool is_free;
+
+    // Nouvel extent: le faire commencer sur une frontière d'AU
+    if (!fat_cluster_is_free(hint, &is_free)) {
+        return false;
+    }
+
+    // exFAT: fichier contigu prolongé par la bitmap seule, DataLength écrite
+    // aussitôt pour que la reprise retrouve les secteurs du nouveau cluster
+    if (exfat) {
+        if (!exfat_contiguous || !is_free || exfat_bitmap_set(hint) <= 0) {
+            return false;  // Pas de conversion en chaîne FAT
+        }
+        free_bitmap_clear(hint);
+        log_extent_push(hint);
+        alloc_record(start_time);
+        return exfat_update_file_size();
+    }
+
+    if (!is_free) {
+        hint = au_align_cluster(fsinfo_next_free);
+    }
+
+    uint32_t cluster = fat_alloc_cluster(last, hint);
+    if (cluster == 0) {
+        return false;
+    }
+
+    log_extent_push(cluster);
+    return true;
+}
+
+// =============================================================================
+// SECTEUR DE FIN PARTAGÉ (JOURNAL ET FICHIERS ANNEXES)
+// =============================================================================
+
+#define TAIL_OWNER_LOG      (-1)    // Journal CSV
+#define TAIL_OWNER_NONE     (-2)    // Contenu sans propriétaire (montage, lecture échouée)
+#define FILE_HANDLE_SLOTS   (FILE_HANDLE_COUNT > 0 ? FILE_HANDLE_COUNT : 1)
+
+// Fichier annexe ouvert. Seule la dernière suite contiguë de clusters est
+// adressable: les écritures se font toujours en fin de fichier.
+typedef struct {
+    bool used;
+    bool checked;               // Entrée revérifiée depuis le montage
+    char name83[11];
+    dir_loc_t dir_loc;
+    uint32_t first_cluster;     // 0 = fichier vide sans cluster
+    uint32_t size;              // Octets écrits, secteur de fin en RAM compris
+    uint32_t size_on_disk;      // Taille commise dans le répertoire
+    uint32_t run_logical;       // Rang dans la chaîne du premier cluster de la suite
+    uint32_t run_cluster;
+    uint32_t run_length;        // 0 = aucun cluster
+} file_handle_t;
+
+static file_handle_t file_handles[FILE_HANDLE_SLOTS];
+static int8_t log_tail_owner = TAIL_OWNER_NONE;     // Handle, ou journal
+static bool file_tail_dirty = false;        // Secteur de fin d'un fichier annexe modifié
+
+// LBA d'un secteur du fichier dans sa dernière suite de clusters (0 = hors suite)
+static uint32_t file_lba(const file_handle_t* h, uint32_t sequence) {
+    uint32_t logical = sequence / sectors_per_cluster;
+    if (h->run_length == 0 || logical < h->run_logical ||
+        logical - h->run_logical >= h->run_length) {
+        return 0;
+    }
+    return cluster_to_sector(h->run_cluster + (logical - h->run_logical)) +
+           sequence % sectors_per_cluster;
+}
+
+// Écrit le dernier secteur entamé d'un fichier annexe
+static bool file_tail_flush(const file_handle_t* h) {
+    if (!file_tail_dirty) {
+        return true;
+    }
+
+    uint32_t lba = file_lba(h, (h->size - 1) / 512);
+    if (lba == 0 || !sd_write_sector(lba, log_tail)) {
+        return false;
+    }
+    file_tail_dirty = false;
+    return true;
+}
+
+// Écrit le secteur de fin de son propriétaire s'il est modifié, puis le libère
+static bool tail_release(void) {
+    if (log_tail_owner == TAIL_OWNER_LOG) {
+        if (!log_flush()) return false;
+    } else if (log_tail_owner >= 0) {
+        if (!file_tail_flush(&file_handles[log_tail_owner])) return false;
+    }
+
+    log_tail_owner = TAIL_OWNER_NONE;
+    return true;
+}
+
+/**
+ * Donne le secteur de fin en RAM au journal ou à un fichier annexe
+ *
+ * Le secteur partiel du nouveau propriétaire est relu sur la carte:
+ * alterner deux fichiers coûte une écriture et une lecture par passage,
+ * les ajouts consécutifs au même fichier restent groupés en RAM.
+ */
+static bool tail_claim(int8_t owner) {
+    if (log_tail_owner == owner) {
+        return true;
+    }
+
+    bool switched = (log_tail_owner != TAIL_OWNER_NONE);
+    if (!tail_release()) {
+        return false;
+    }
+
+    uint32_t lba = 0;
+    if (owner == TAIL_OWNER_LOG) {
+        if (csv_byte_offset > 0) lba = log_lba(csv_next_seq);
+    } else {
+        const file_handle_t* h = &file_handles[owner];
+        if (h->size % 512 != 0) lba = file_lba(h, h->size / 512);
+    }
+
+    if (lba != 0) {
+        if (!sd_read_sector(lba, log_tail)) {
+            return false;
+        }
+        fs_stats.tail_reloads++;
+    }
+
+    log_tail_owner = owner;
+    if (switched) fs_stats.tail_switches++;
+    return true;
+}
+
+// =============================================================================
+// JOURNAL CSV - EN-TÊTES DE SECTEUR ET RÉCUPÉRATION DE FIN DE LOG
+// =============================================================================
+
+static bool parse_hex32(const uint8_t* p, uint32_t* value) {
+    uint32_t v = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        uint8_t c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') {
+            v |= (uint32_t)(c - '0');
+        } else if (c >= 'A' && c <= 'F') {
+            v |= (uint32_t)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+
+    *value = v;
+    return true;
+}
+
+// Décode l'en-tête "#SDL <génération> <séquence>\n" d'un secteur du journal
+static bool log_parse_header(const uint8_t* buffer, uint32_t* generation, uint32_t* sequence) {
+    if (memcmp(buffer, LOG_SECTOR_MAGIC, 4) != 0 ||
+        buffer[4] != ' ' || buffer[13] != ' ' || buffer[22] != '\n') {
+        return false;
+    }
+    return parse_hex32(&buffer[5], generation) && parse_hex32(&buffer[14], sequence);
+}
+
+// Prépare un secteur vierge du journal avec son en-tête
+static void log_begin_sector(uint32_t sequence) {
+    memset(log_tail, 0, 512);
+    snprintf((char*)log_tail, LOG_SECTOR_HDR_SIZE + 1, LOG_SECTOR_MAGIC " %08lX %08lX\n",
+             csv_generation, sequence);
+}
+
+// Démarre un journal vide avec une génération différente des données résiduelles
+static void log_reset(uint32_t stale_generation) {
+    csv_generation = (micros() * 2654435761UL) ^ GET_BATTERY_MV();
+    if (csv_generation == stale_generation) {
+        csv_generation++;
+    }
+
+    csv_next_seq = 0;
+    csv_byte_offset = 0;
+    header_written = false;
+}
+
+/**
+ * Teste si un secteur appartient au journal courant
+ * @return 1 si génération et séquence correspondent, 0 sinon, -1 si erreur de lecture
+ */
+static int8_t log_probe(uint32_t sequence) {
+    uint32_t generation, seq;
+
+    uint32_t lba = log_lba(sequence);
+    if (lba == 0) {
+        return 0;
+    }
+
+    fs_stats.recovery_probes++;
+    if (!sd_read_sector(lba, sector_buffer)) {
+        return -1;
+    }
+
+    return (log_parse_header(sector_buffer, &generation, &seq) &&
+            generation == csv_generation && seq == sequence) ? 1 : 0;
+}
+
+// Des extents ont été oubliés entre l'extent 0 et le suivant
+static bool log_extents_dropped(void) {
+    return log_extent_count > 1 && log_extents[1].logical > log_extents[0].length;
+}
+
+/**
+ * Coupe la chaîne du journal après l'extent 0
+ *
+ * La suite, laissée par une génération périmée, n'est pas adressable une
+ * fois des extents oubliés: le journal courant y écrirait sans les
+ * retrouver. Sur exFAT la chaîne est laissée en place (pas de bitmap
+ * libérée ici), seul l'extent 0 reste utilisé.
+ */
+static bool log_truncate_to_first_extent(void) {
+    const log_extent_t* ext = &log_extents[0];
+    uint32_t last = ext->cluster + ext->length - 1;
+    uint32_t next = 0;
+
+    if (!exfat && (!fat_get(last, &next) || !fat_set(last, FAT32_EOC))) {
+        return false;
+    }
+
+    log_extent_count = 1;
+    csv_alloc_sectors = ext->length * sectors_per_cluster;
+    fs_stats.log_extents = 1;
+    fs_stats.log_extents_dropped = 0;
+    return exfat || next < 2 || next >= FAT32_EOC_MIN || fat_free_chain(next, false);
+}
+
+/**
+ * Retrouve le dernier secteur écrit du journal et y positionne l'écriture
+ *
+ * Les secteurs écrits forment un préfixe de séquences valides: recherche
+ * exponentielle depuis l'indice fourni puis dichotomie, soit O(log n)
+ * lectures au lieu d'un scan linéaire de la zone.
+ *
+ * @param hint Séquence probable du dernier secteur (position RAM ou taille du répertoire)
+ */
+static bool log_recover_tail(uint32_t hint) {
+    uint32_t start_time = micros();
+    uint32_t generation = 0, sequence;
+    int8_t probe;
+
+    fs_stats.recovery_probes = 1;
+    if (!sd_read_sector(csv_start_sector, sector_buffer)) {
+        return false;
+    }
+
+    if (!log_parse_header(sector_buffer, &generation, &sequence) || sequence != 0) {
+        // Aucun secteur du journal: fichier vide ou ancien format
+        if (log_extents_dropped() && !log_truncate_to_first_extent()) {
+            return false;
+        }
+        log_reset(generation);
+        fs_stats.log_tail_sector = 0;
+        fs_stats.log_tail_offset = 0;
+        fs_stats.recovery_time_us = micros() - start_time;
+        return true;
+    }
+    csv_generation = generation;
+
+    // lo: dernier secteur connu valide, hi: premier secteur connu invalide
+    uint32_t lo = 0;
+    uint32_t hi = csv_alloc_sectors;
+
+    // Extents oubliés entre l'extent 0 et le suivant: si le premier extent
+    // retenu appartient au journal, les séquences oubliées le précèdent et
+    // sont valides, la recherche part de là. Sinon la fin est dans
+    // l'extent 0 et la chaîne au-delà date d'une génération périmée.
+    if (log_extents_dropped()) {
+        uint32_t base = log_extents[1].logical * sectors_per_cluster;
+        probe = log_probe(base);
+        if (probe < 0) return false;
+        if (probe > 0) {
+            lo = base;
+        } else {
+            if (!log_truncate_to_first_extent()) return false;
+            hi = csv_alloc_sectors;
+        }
+    }
+
+    if (hint > lo && hint < hi) {
+        probe = log_probe(hint);
+        if (probe < 0) return false;
+        if (probe > 0) {
+            lo = hint;
+        } else {
+            hi = hint;
+        }
+    }
+
+    for (;;) {
+        // Recherche exponentielle vers le haut
+        uint32_t step = 1;
+        while (step < hi - lo) {
+            probe = log_probe(lo + step);
+            if (probe < 0) return false;
+            if (probe == 0) {
+                hi = lo + step;
+                break;
+            }
+            lo += step;
+            step <<= 1;
+        }
+
+        // Dichotomie
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            probe = log_probe(mid);
+            if (probe < 0) return false;
+            if (probe > 0) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+
+        // Journal plein jusqu'au bout de la chaîne: le cluster suivant a pu
+        // être écrit avant que sa FAT ne soit vidée (coupure d'alimentation)
+        if (lo + 1 != csv_alloc_sectors) {
+            break;
+        }
+
+        const log_extent_t* ext = &log_extents[log_extent_count - 1];
+        uint32_t next = ext->cluster + ext->length;
+        uint32_t generation_next, sequence_next;
+        bool is_free;
+
+        if (!fat_cluster_is_free(next, &is_free)) return false;
+        if (!is_free) break;
+
+        fs_stats.recovery_probes++;
+        if (!sd_read_sector(cluster_to_sector(next), sector_buffer)) return false;
+        if (!log_parse_header(sector_buffer, &generation_next, &sequence_next) ||
+            generation_next != csv_generation || sequence_next != csv_alloc_sectors) {
+            break;
+        }
+
+        if (!log_grow()) return false;
+        lo = sequence_next;
+        hi = csv_alloc_sectors;
+    }
+
+    // Position d'écriture: premier octet nul après l'en-tête du dernier secteur
+    fs_stats.recovery_probes++;
+    if (!sd_read_sector(log_lba(lo), sector_buffer)) {
+        return false;
+    }
+
+    uint16_t offset = LOG_SECTOR_HDR_SIZE;
+    while (offset < 512 && sector_buffer[offset] != 0) {
+        offset++;
+    }
+
+    if (offset >= 512) {
+        csv_next_seq = lo + 1;
+        csv_byte_offset = 0;
+    } else {
+        // Secteur partiel repris en RAM, après celui d'un fichier annexe
+        if (!tail_release()) {
+            return false;
+        }
+        csv_next_seq = lo;
+        csv_byte_offset = offset;
+        memcpy(log_tail, sector_buffer, 512);
+        log_tail_owner = TAIL_OWNER_LOG;
+    }
+    header_written = (lo > 0 || offset > LOG_SECTOR_HDR_SIZE);
+
+    fs_stats.log_tail_sector = lo;
+    fs_stats.log_tail_offset = offset;
+    fs_stats.recovery_time_us = micros() - start_time;
+    return true;
+}
+
+/**
+ * Extrait cycle et époque de la dernière ligne de données d'un secteur du journal
+ *
+ * Les lignes de commentaire, l'en-tête CSV et le bourrage sont ignorés.
+ * Une ligne d'un ancien format sans colonne boot_epoch donne l'époque 0.
+ *
+ * @param end Nombre d'octets utilisés dans le secteur
+ */
+static bool log_parse_last_record(const uint8_t* buffer, uint16_t end, uint32_t* cycle, uint32_t* epoch) {
+    ram_lease_t lease;
+    char* line = (char*)ram_lease(&lease, CSV_LINE_MAX_SIZE);
+    bool found = false;
+
+    while (line != nullptr && !found && end > LOG_SECTOR_HDR_SIZE) {
+        // Remonter à la ligne précédente
+        while (end > LOG_SECTOR_HDR_SIZE && buffer[end - 1] == '\n') end--;
+        uint16_t start = end;
+        while (start > LOG_SECTOR_HDR_SIZE && buffer[start - 1] != '\n') start--;
+
+        uint16_t len = end - start;
+        if (len > 0 && len < CSV_LINE_MAX_SIZE && buffer[start] >= '0' && buffer[start] <= '9') {
+            memcpy(line, &buffer[start], len);
+            line[len] = '\0';
+
+            char* field = line;
+            *epoch = 0;
+            for (uint8_t col = 0; field != nullptr; col++) {
+                if (col == CSV_COL_CYCLE) {
+                    *cycle = strtoul(field, nullptr, 10);
+                } else if (col == CSV_COL_BOOT_EPOCH) {
+                    *epoch = strtoul(field, nullptr, 10);
+                }
+                field = strchr(field, ',');
+                if (field != nullptr) field++;
+            }
+            found = true;
+        }
+        end = start;
+    }
+
+    ram_release(&lease);
+    return found;
+}
+
+/**
+ * Ajoute du texte au journal sans jamais couper une ligne entre deux secteurs
+ *
+ * Le secteur de fin est complété en RAM et écrit quand il est plein ou
+ * après flush_batch_lines ajouts (CSV_FLUSH_BATCH_LINES ou profil de carte). Si l'écriture échoue, l'ajout est
+ * annulé et peut être rejoué.
+ */
+static bool log_append(const char* text, uint16_t len) {
+    if (len > 512 - LOG_SECTOR_HDR_SIZE || !tail_claim(TAIL_OWNER_LOG)) {
+        return false;
+    }
+
+    if (csv_byte_offset > 0 && csv_byte_offset + len > 512) {
+        // Bourrage: la ligne commence au secteur suivant
+        memset(&log_tail[csv_byte_offset], '\n', 512 - csv_byte_offset);
+        log_tail_dirty = true;
+        if (!log_flush()) {
+            return false;
+        }
+        csv_next_seq++;
+        csv_byte_offset = 0;
+    }
+
+    uint16_t offset = csv_byte_offset;
+    if (offset == 0) {
+        if (csv_next_seq >= csv_alloc_sectors && !log_grow()) {
+            return false;  // Volume plein
+        }
+        if (log_lba(csv_next_seq) == 0) {
+            return false;
+        }
+        log_begin_sector(csv_next_seq);
+        offset = LOG_SECTOR_HDR_SIZE;
+    }
+
+    memcpy(&log_tail[offset], text, len);
+    log_tail_dirty = true;
+    log_tail_lines++;
+
+    if (offset + len >= 512 || log_tail_lines >= flush_batch_lines) {
+        if (!log_flush()) {
+            memset(&log_tail[offset], 0, len);
+            log_tail_lines--;
+            if (csv_byte_offset == 0) log_tail_dirty = false;
+            return false;
+        }
+    }
+
+    offset += len;
+    if (offset >= 512) {
+        csv_next_seq++;
+        csv_byte_offset = 0;
+    } else {
+        csv_byte_offset = offset;
+    }
+    fs_stats.log_bytes_appended += len;
+    return true;
+}
+
+// Journal vide dans un fichier qui vient d'être créé sur first_cluster
+static bool log_open_new(uint32_t first_cluster) {
+    csv_first_cluster = first_cluster;
+    csv_size_on_disk = 0;
+    csv_start_sector = cluster_to_sector(first_cluster);
+    log_extent_count = 0;
+    csv_alloc_sectors = 0;
+    fs_stats.log_extents = 0;
+    fs_stats.log_extents_dropped = 0;
+    log_extent_push(first_cluster);
+
+    // Nouveau journal: génération distincte d'un éventuel ancien contenu
+    uint32_t recovery_start = micros();
+    uint32_t stale_generation = 0, sequence;
+    if (!sd_read_sector(csv_start_sector, sector_buffer)) {
+        return false;
+    }
+    log_parse_header(sector_buffer, &stale_generation, &sequence);
+    log_reset(stale_generation);
+
+    fs_stats.recovery_probes = 1;
+    fs_stats.log_tail_sector = 0;
+    fs_stats.log_tail_offset = 0;
+    fs_stats.recovery_time_us = micros() - recovery_start;
+    return true;
+}
+
+// Indice de recherche de fin: taille du répertoire, ou position RAM si même fichier
+static uint32_t log_tail_hint(uint32_t start_sector, uint32_t file_size) {
+    uint32_t hint = (file_size > 0) ? (file_size - 1) / 512 : 0;
+
+    if (start_sector == csv_start_sector && (csv_next_seq > 0 || csv_byte_offset > 0)) {
+        hint = csv_next_seq;
+        if (csv_byte_offset == 0) hint--;
+    }
+    return hint;
+}
+
+/**
+ * Trouve ou crée le fichier CSV actif dans la racine exFAT
+ *
+ * Un fichier créé ici est contigu (NoFatChain): un cluster aligné sur une
+ * AU, prolongé cluster par cluster via la bitmap. Un fichier existant à
+ * chaîne FAT est repris mais ne peut pas croître au-delà de son allocation.
+ */
+static bool exfat_find_or_create_file(void) {
+    uint32_t start_time = micros();
+    char name[12];
+    uint8_t len = exfat_long_name(csv_name83, name);
+    dir_loc_t found, free_slot;
+    int8_t result = 0;
+
+    fs_stats.dir_lookup_sectors = 0;
+    fs_stats.dir_cache_hit = false;
+
+    // Emplacement connu du montage précédent: relire l'entrée flux
+    if (csv_dir_loc.sector != 0) {
+        fs_stats.dir_lookup_sectors = 1;
+        if (!sd_read_sector(csv_dir_loc.sector, sector_buffer)) {
+            return false;
+        }
+        const uint8_t* entry = &sector_buffer[csv_dir_loc.index * 32];
+        if (entry[0] == EXFAT_ENTRY_STREAM && get_le32(&entry[20]) == csv_first_cluster) {
+            memcpy(&exfat_set[32], entry, 32);
+            found = csv_dir_loc;
+            result = 1;
+            fs_stats.dir_cache_hit = true;
+        }
+    }
+
+    if (result == 0) {
+        result = exfat_find(name, len, &found, &free_slot);
+        if (result < 0) {
+            return false;
+        }
+    }
+
+    if (result > 0) {
+        const uint8_t* stream = &exfat_set[32];
+        uint32_t start_cluster = get_le32(&stream[20]);
+        uint32_t file_size = get_le32(&stream[8]);
+        fs_stats.dir_lookup_time_us = micros() - start_time;
+
+        // Fichier vide sans cluster ou de plus de 4 Go: non géré
+        if (start_cluster < 2 || start_cluster > cluster_count + 1 ||
+            get_le32(&stream[12]) != 0 || get_le32(&stream[28]) != 0) {
+            return false;
+        }
+
+        exfat_contiguous = stream[1] & EXFAT_NO_FAT_CHAIN;
+        exfat_data_length = get_le32(&stream[24]);
+        uint32_t start_sector = cluster_to_sector(start_cluster);
+        uint32_t hint = log_tail_hint(start_sector, file_size);
+
+        if (!fs_stats.dir_cache_hit || log_extent_count == 0) {
+            if (exfat_contiguous) {
+                uint32_t cluster_bytes = (uint32_t)sectors_per_cluster * 512;
+                uint32_t clusters = (exfat_data_length + cluster_bytes - 1) / cluster_bytes;
+
+                log_extent_count = 1;
+                log_extents[0].logical = 0;
+                log_extents[0].cluster = start_cluster;
+                log_extents[0].length = clusters;
+                csv_alloc_sectors = clusters * sectors_per_cluster;
+                fs_stats.log_extents = 1;
+                fs_stats.log_extents_dropped = 0;
+            } else if (!log_load_extents(start_cluster)) {
+                return false;
+            }
+        }
+
+        csv_dir_loc = found;
+        csv_first_cluster = start_cluster;
+        csv_size_on_disk = file_size;
+        csv_start_sector = start_sector;
+        return log_recover_tail(hint);
+    }
+
+    // La racine n'est pas étendue sur exFAT
+    if (free_slot.sector == 0) {
+        return false;
+    }
+    fs_stats.dir_lookup_time_us = micros() - start_time;
+
+    // Cluster marqué dans la bitmap avant d'écrire le jeu d'entrées
+    uint32_t new_cluster = fat_alloc_cluster(0, au_align_cluster(fsinfo_next_free));
+    if (new_cluster == 0) {
+        return false;
+    }
+
+    memset(exfat_set, 0, sizeof(exfat_set));
+    exfat_set[0] = EXFAT_ENTRY_FILE;
+    exfat_set[1] = 2;
+    put_le16(&exfat_set[4], 0x20);      // Attribut archive, dates à zéro
+    exfat_set[32] = EXFAT_ENTRY_STREAM;
+    exfat_set[33] = EXFAT_ALLOC_POSSIBLE | EXFAT_NO_FAT_CHAIN;
+    exfat_set[35] = len;
+    put_le16(&exfat_set[36], exfat_name_hash(name, len));
+    put_le32(&exfat_set[52], new_cluster);
+    put_le32(&exfat_set[56], (uint32_t)sectors_per_cluster * 512);
+    exfat_set[64] = EXFAT_ENTRY_NAME;
+    for (uint8_t i = 0; i < len; i++) {
+        put_le16(&exfat_set[66 + i * 2], (uint8_t)name[i]);
+    }
+    put_le16(&exfat_set[2], exfat_set_checksum(exfat_set, EXFAT_SET_SIZE));
+
+    // Jeu au secteur suivant: les lecteurs s'arrêtent au premier 0x00, les
+    // marqueurs de fin qui le précèdent deviennent des entrées libres
+    if (exfat_end_loc.sector != 0) {
+        if (!sd_read_sector(exfat_end_loc.sector, sector_buffer)) {
+            return false;
+        }
+        for (uint8_t i = exfat_end_loc.index; i < 16; i++) {
+            if (sector_buffer[i * 32] == 0x00) {
+                sector_buffer[i * 32] = EXFAT_ENTRY_UNUSED;
+            }
+        }
+        if (!sd_write_sector(exfat_end_loc.sector, sector_buffer)) {
+            return false;
+        }
+    }
+
+    if (!sd_read_sector(free_slot.sector, sector_buffer)) {
+        return false;
+    }
+    memcpy(&sector_buffer[free_slot.index * 32], exfat_set, EXFAT_SET_SIZE);
+    if (!sd_write_sector(free_slot.sector, sector_buffer)) {
+        return false;
+    }
+
+    exfat_file_loc = free_slot;
+    exfat_contiguous = true;
+    exfat_data_length = (uint32_t)sectors_per_cluster * 512;
+    csv_dir_loc.sector = free_slot.sector;
+    csv_dir_loc.index = free_slot.index + 1;
+    return log_open_new(new_cluster);
+}
+
+// Met à jour la taille du fichier CSV dans son entrée de répertoire
+static bool fat32_update_file_size(void) {
+    if (exfat) {
+        return exfat_update_file_size();
+    }
+
+    uint32_t size = csv_next_seq * 512 + csv_byte_offset;
+
+    if (size == csv_size_on_disk || csv_dir_loc.sector == 0) {
+        return true;
+    }
+
+    if (!sd_read_sector(csv_dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+    put_le32(&sector_buffer[csv_dir_loc.index * 32 + 0x1C], size);
+    if (!sd_write_sector(csv_dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+
+    csv_size_on_disk = size;
+    return true;
+}
+
+// Trouve ou crée le fichier CSV actif (csv_name83) dans le répertoire racine
+static bool fat32_find_or_create_file(void) {
+    if (exfat) {
+        return exfat_find_or_create_file();
+    }
+
+    uint32_t start_time = micros();
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = 0;
+
+    fs_stats.dir_lookup_sectors = 0;
+    fs_stats.dir_cache_hit = false;
+
+    // Emplacement connu du montage précédent: une seule lecture
+    if (csv_dir_loc.sector != 0) {
+        fs_stats.dir_lookup_sectors = 1;
+        if (!sd_read_sector(csv_dir_loc.sector, sector_buffer)) {
+            return false;
+        }
+        const uint8_t* entry = &sector_buffer[csv_dir_loc.index * 32];
+        if (memcmp(entry, csv_name83, 11) == 0 && dir_entry_cluster(entry) == csv_first_cluster) {
+            found = csv_dir_loc;
+            result = 1;
+            fs_stats.dir_cache_hit = true;
+        }
+    }
+
+    // Sinon parcours complet de la chaîne du répertoire racine
+    if (result == 0) {
+        result = dir_find(root_cluster, csv_name83, &found, &free_slot, &last_cluster);
+        if (result < 0) {
+            return false;
+        }
+    }
+
+    if (result > 0) {
+        const uint8_t* entry = &sector_buffer[found.index * 32];
+        uint32_t start_cluster = dir_entry_cluster(entry);
+        uint32_t file_size = get_le32(&entry[0x1C]);
+        fs_stats.dir_lookup_time_us = micros() - start_time;
+
+        uint32_t start_sector = cluster_to_sector(start_cluster);
+        uint32_t hint = log_tail_hint(start_sector, file_size);
+
+        // Table d'extents gardée en RAM tant que le fichier est le même
+        if (!fs_stats.dir_cache_hit || log_extent_count == 0) {
+            if (!log_load_extents(start_cluster)) {
+                return false;
+            }
+        }
+
+        csv_dir_loc = found;
+        csv_first_cluster = start_cluster;
+        csv_size_on_disk = file_size;
+        csv_start_sector = start_sector;
+        return log_recover_tail(hint);
+    }
+
+    // Répertoire plein: ajouter un cluster à sa chaîne
+    if (free_slot.sector == 0 && !dir_extend(last_cluster, &free_slot)) {
+        return false;
+    }
+    fs_stats.dir_lookup_time_us = micros() - start_time;
+
+    // Allouer le premier cluster avant d'écrire l'entrée: un arrêt entre
+    // les deux laisse au pire un cluster perdu, jamais une entrée invalide
+    uint32_t new_cluster = fat_alloc_cluster(0, au_align_cluster(fsinfo_next_free));
+    if (new_cluster == 0 || !fat_cache_flush()) {
+        return false;
+    }
+
+    if (!dir_write_entry(&free_slot, csv_name83, new_cluster, 0)) {
+        return false;
+    }
+
+    csv_dir_loc = free_slot;
+    return log_open_new(new_cluster);
+}
+
+// =============================================================================
+// FICHIER DE TRAVAIL (SCRATCH) POUR LES CHARGES DE TEST
+// =============================================================================
+
+// Fichier contigu: les charges de test y adressent des secteurs bruts
+// sans jamais toucher au reste du volume
+static dir_loc_t scratch_dir_loc = {0, 0};
+static uint32_t scratch_first_cluster = 0;
+static uint32_t scratch_sectors = 0;
+
+// Cherche count clusters libres consécutifs dans [from, to]
+static uint32_t fat_find_free_run(uint32_t from, uint32_t to, uint32_t count) {
+    uint32_t run = 0;
+
+    for (uint32_t c = from; c <= to; c++) {
+        bool is_free;
+        if (!fat_cluster_is_free(c, &is_free)) {
+            return 0;
+        }
+        if (!is_free) {
+            run = 0;
+            continue;
+        }
+        if (++run == count) {
+            return c - count + 1;
+        }
+    }
+    return 0;
+}
+
+// Chaîne une suite de clusters libres en un seul fichier contigu
+static bool fat_alloc_run(uint32_t first, uint32_t count) {
+    uint32_t value;
+
+    // La bitmap peut être périmée: tout vérifier avant de modifier la FAT
+    for (uint32_t i = 0; i < count; i++) {
+        if (!fat_get(first + i, &value) || value != 0) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!fat_set(first + i, (i + 1 < count) ? first + i + 1 : FAT32_EOC)) {
+            return false;
+        }
+        free_bitmap_clear(first + i);
+    }
+
+    if (fsinfo_free_count != FSINFO_UNKNOWN) {
+        fsinfo_free_count -= count;
+    }
+    fsinfo_next_free = (first + count <= cluster_count + 1) ? first + count : 2;
+    fsinfo_dirty = true;
+    return fat_cache_flush();
+}
+
+// Vérifie qu'une chaîne existante est contiguë sur count clusters
+static bool fat_chain_is_contiguous(uint32_t first, uint32_t count) {
+    uint32_t cluster = first;
+
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t next;
+        if (!fat_get(cluster, &next) || next != cluster + 1) {
+            return false;
+        }
+        cluster = next;
+    }
+    return true;
+}
+
+/**
+ * Ouvre ou crée un fichier contigu d'au moins sectors secteurs
+ *
+ * Un fichier existant trop court ou fragmenté est réalloué d'un bloc
+ * (ancienne chaîne libérée, même entrée de répertoire). L'entrée reçoit
+ * la taille allouée.
+ */
+static sd_error_t contig_file_open(const char* name, uint32_t sectors,
+                                   dir_loc_t* loc, uint32_t* first_cluster) {
+    uint32_t clusters = (sectors + sectors_per_cluster - 1) / sectors_per_cluster;
+    if (clusters == 0) {
+        clusters = 1;
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = dir_find(root_cluster, name, &found, &free_slot, &last_cluster);
+    if (result < 0) {
+        return ERR_FILE_OPEN_FAILED;
+    }
+
+    if (result > 0) {
+        uint32_t first = dir_entry_cluster(&sector_buffer[found.index * 32]);
+        if (first >= 2 && fat_chain_is_contiguous(first, clusters)) {
+            *loc = found;
+            *first_cluster = first;
+            return ERR_NONE;
+        }
+        if (first >= 2 && !fat_free_chain(first, false)) {
+            return ERR_FILE_WRITE_FAILED;
+        }
+        free_slot = found;
+    } else if (free_slot.sector == 0 && !dir_extend(last_cluster, &free_slot)) {
+        return ERR_FILE_OPEN_FAILED;
+    }
+
+    uint32_t start = au_align_cluster(fsinfo_next_free);
+    uint32_t first = fat_find_free_run(start, cluster_count + 1, clusters);
+    if (first == 0) {
+        first = fat_find_free_run(2, start, clusters);
+    }
+    if (first == 0) {
+        return ERR_VOLUME_FULL;
+    }
+
+    // Chaîne écrite avant l'entrée: au pire des clusters perdus après coupure
+    if (!fat_alloc_run(first, clusters) ||
+        !dir_write_entry(&free_slot, name, first, clusters * sectors_per_cluster * 512)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    *loc = free_slot;
+    *first_cluster = first;
+    return ERR_NONE;
+}
+
+// =============================================================================
+// OPÉRATIONS DE MÉTADONNÉES (CHARGE DE TEST)
+// =============================================================================
+
+// Recherche dans le répertoire de travail, temps et secteurs comptés
+static int8_t meta_lookup(const char* name, dir_loc_t* found, dir_loc_t* free_slot,
+                          uint32_t* last_cluster, sd_meta_timing_t* t) {
+    uint32_t start = micros();
+    uint32_t sectors = fs_stats.dir_lookup_sectors;
+
+    int8_t result = dir_find(meta_dir_cluster, name, found, free_slot, last_cluster);
+
+    t->scan_us += micros() - start;
+    t->dir_sectors += fs_stats.dir_lookup_sectors - sectors;
+    return result;
+}
+
+// Ajoute bytes octets de remplissage à la fin d'une chaîne, alloue au besoin
+// (en cas d'échec, les clusters alloués par l'appel sont rendus)
+static bool meta_append_data(uint32_t* first, uint32_t size, uint32_t bytes, sd_meta_timing_t* t) {
+    uint32_t cluster_bytes = (uint32_t)sectors_per_cluster * 512;
+    uint32_t cluster = *first;
+    uint32_t index = 0;
+    uint32_t tail = 0;      // Fin de la chaîne d'origine (0 = chaîne créée ici)
+    uint32_t grown = 0;     // Premier cluster alloué par cet appel
+    uint32_t start;
+    bool ok = true;
+
+    while (ok && bytes > 0) {
+        // Cluster contenant la position size, alloué s'il n'existe pas encore
+        start = micros();
+        uint32_t target = size / cluster_bytes;
+        if (cluster == 0) {
+            cluster = fat_alloc_cluster(0, 0);
+            *first = cluster;
+            grown = cluster;
+            index = 0;
+        }
+        while (cluster != 0 && index < target) {
+            uint32_t next;
+            if (!fat_get(cluster, &next)) {
+                cluster = 0;
+                break;
+            }
+            if (next < 2 || next >= FAT32_EOC_MIN) {
+                next = fat_alloc_cluster(cluster, cluster + 1);
+                if (grown == 0) {
+                    grown = next;
+                    tail = cluster;
+                }
+            }
+            cluster = next;
+            index++;
+        }
+        t->fat_us += micros() - start;
+        if (cluster == 0) {
+            ok = false;
+            break;
+        }
+
+        start = micros();
+        uint32_t sector = cluster_to_sector(cluster) + (size % cluster_bytes) / 512;
+        uint16_t offset = size % 512;
+        uint16_t chunk = (bytes < 512U - offset) ? bytes : 512 - offset;
+
+        if (offset != 0) {
+            ok = sd_read_sector(sector, sector_buffer);
+        } else {
+            memset(sector_buffer, 0, 512);
+        }
+        if (ok) {
+            memset(&sector_buffer[offset], 'x', chunk);
+            ok = sd_write_sector(sector, sector_buffer);
+        }
+        t->data_us += micros() - start;
+
+        size += chunk;
+        bytes -= chunk;
+    }
+
+    start = micros();
+    if (!ok && grown != 0) {
+        // L'entrée n'est pas réécrite: couper la chaîne à sa fin d'origine
+        if (tail != 0) {
+            fat_set(tail, FAT32_EOC);
+        } else {
+            *first = 0;
+        }
+        fat_free_chain(grown, false);
+    }
+    ok = fat_cache_flush() && ok;
+    t->fat_us += micros() - start;
+    return ok;
+}
+
+// Libère une chaîne dont l'entrée ne pointe plus dessus
+static bool meta_free_chain(uint32_t first, sd_meta_timing_t* t) {
+    uint32_t start = micros();
+    bool ok = (first < 2) || fat_free_chain(first, false);
+    t->fat_us += micros() - start;
+    return ok;
+}
+
+// =============================================================================
+// CHECKPOINT DES STATISTIQUES (SECTEURS RÉSERVÉS A/B)
+// =============================================================================
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t length;
+    uint16_t reserved;
+} checkpoint_header_t;
+
+static uint32_t checkpoint_sequence = 0;
+
+// Slot A (0) ou B (1): les deux derniers secteurs de la zone réservée du volume
+static uint32_t checkpoint_sector(uint8_t slot) {
+    return volume_start_sector + reserved_sectors - 2 + slot;
+}
+
+// Lit un slot dans sector_buffer et vérifie magic, taille et CRC
+static bool checkpoint_read_slot(uint8_t slot, uint16_t len, uint32_t* sequence) {
+    checkpoint_header_t header;
+    uint32_t crc;
+
+    if (!sd_read_sector(checkpoint_sector(slot), sector_buffer)) {
+        return false;
+    }
+
+    memcpy(&header, sector_buffer, sizeof(header));
+    if (header.magic != CHECKPOINT_MAGIC || header.length != len) {
+        return false;
+    }
+
+    memcpy(&crc, &sector_buffer[sizeof(header) + len], sizeof(crc));
+    if (crc != crc32_compute(sector_buffer, sizeof(header) + len)) {
+        return false;
+    }
+
+    *sequence = header.sequence;
+    return true;
+}
+
+// =============================================================================
+// ROTATION DU JOURNAL (SD_00001.CSV, SD_00002.CSV...)
+// =============================================================================
+
+#define LOG_INDEX_MAGIC     0x58444C53UL    // "SLDX"
+#define LOG_CYCLE_UNKNOWN   0xFFFFFFFFUL
+
+// Secteur d'index: fichier actif et emplacement de son entrée
+typedef struct {
+    uint32_t magic;
+    uint32_t number;            // Numéro du fichier actif
+    uint32_t first_cycle;       // Premier cycle écrit dans ce fichier
+    uint32_t dir_sector;        // Entrée de répertoire du fichier
+    uint32_t first_cluster;
+    uint16_t dir_index;
+    uint16_t reserved;
+} log_index_t;
+
+static uint32_t log_file_number = 0;
+static uint32_t log_first_cycle = LOG_CYCLE_UNKNOWN;
+static bool log_index_dirty = false;        // Index à réécrire avant la prochaine ligne
+
+// Juste avant les slots de checkpoint
+static uint32_t log_index_sector(void) {
+    return checkpoint_sector(0) - 1;
+}
+
+static void log_set_file_number(uint32_t number) {
+    log_file_number = number;
+    fs_stats.log_file_number = number;
+    snprintf(csv_name83, sizeof(csv_name83), "SD_%05luCSV", number % 100000UL);
+}
+
+/**
+ * Relit le secteur d'index et y prend le fichier actif
+ *
+ * L'emplacement d'entrée est vérifié par fat32_find_or_create_file(): un
+ * index périmé coûte un parcours du répertoire, jamais un mauvais fichier.
+ */
+static bool log_index_load(void) {
+    log_index_t index;
+    uint32_t crc;
+
+    if (reserved_sectors < CHECKPOINT_MIN_RESERVED ||
+        !sd_read_sector(log_index_sector(), sector_buffer)) {
+        return false;
+    }
+
+    memcpy(&index, sector_buffer, sizeof(index));
+    memcpy(&crc, &sector_buffer[sizeof(index)], sizeof(crc));
+    if (index.magic != LOG_INDEX_MAGIC || index.number == 0 ||
+        crc != crc32_compute(sector_buffer, sizeof(index))) {
+        return false;
+    }
+
+    log_set_file_number(index.number);
+    log_first_cycle = index.first_cycle;
+    csv_dir_loc.sector = index.dir_sector;
+    csv_dir_loc.index = index.dir_index & 0x0F;
+    csv_first_cluster = index.first_cluster;
+    fs_stats.log_index_scan_sectors = 0;
+    return true;
+}
+
+static bool log_index_store(void) {
+    log_index_t index;
+
+    if (reserved_sectors < CHECKPOINT_MIN_RESERVED) {
+        log_index_dirty = false;
+        return true;  // Pas de place: le montage parcourra le répertoire
+    }
+
+    index.magic = LOG_INDEX_MAGIC;
+    index.number = log_file_number;
+    index.first_cycle = log_first_cycle;
+    index.dir_sector = csv_dir_loc.sector;
+    index.first_cluster = csv_first_cluster;
+    index.dir_index = csv_dir_loc.index;
+    index.reserved = 0;
+
+    memset(sector_buffer, 0, 512);
+    memcpy(sector_buffer, &index, sizeof(index));
+    uint32_t crc = crc32_compute(sector_buffer, sizeof(index));
+    memcpy(&sector_buffer[sizeof(index)], &crc, sizeof(crc));
+
+    if (!sd_write_sector(log_index_sector(), sector_buffer)) {
+        return false;
+    }
+    log_index_dirty = false;
+    return true;
+}
+
+// Numéro d'un nom 8.3 "SD_nnnnnCSV", 0 si le nom ne correspond pas
+static uint32_t log_parse_name(const uint8_t* name) {
+    uint32_t number = 0;
+
+    if (memcmp(name, "SD_", 3) != 0 || memcmp(&name[8], "CSV", 3) != 0) {
+        return 0;
+    }
+    for (uint8_t i = 3; i < 8; i++) {
+        if (name[i] < '0' || name[i] > '9') {
+            return 0;
+        }
+        number = number * 10 + (name[i] - '0');
+    }
+    return number;
+}
+
+/**
+ * Sans index valide: parcourt le répertoire racine et reprend le fichier
+ * de plus grand numéro (SD_00001.CSV sur un volume vierge)
+ */
+static bool log_scan_latest(void) {
+    dir_cursor_t cursor;
+    uint32_t sector;
+    uint32_t latest = 0;
+    int8_t next;
+    bool end = false;
+
+    fs_stats.log_index_scan_sectors = 0;
+    dir_cursor_init(&cursor, root_cluster);
+
+    while (!end && (next = dir_cursor_next(&cursor, &sector)) > 0) {
+        if (!sd_read_sector(sector, sector_buffer)) {
+            return false;
+        }
+        fs_stats.log_index_scan_sectors++;
+
+        for (uint8_t i = 0; i < 16; i++) {
+            const uint8_t* entry = &sector_buffer[i * 32];
+            if (entry[0] == 0x00) {
+                end = true;  // Fin du répertoire
+                break;
+            }
+            if (entry[0] == 0xE5 || entry[0x0B] == 0x0F || (entry[0x0B] & 0x18)) {
+                continue;
+            }
+            uint32_t number = log_parse_name(entry);
+            if (number > latest) {
+                latest = number;
+            }
+        }
+    }
+
+    if (!end && next < 0) {
+        return false;
+    }
+
+    log_set_file_number(latest > 0 ? latest : 1);
+    log_first_cycle = LOG_CYCLE_UNKNOWN;
+    return true;
+}
+
+// Supprime un ancien fichier du journal (entrée d'abord, puis sa chaîne
+// effacée: la carte ne recopie plus ces blocs lors de son ramasse-miettes)
+static bool log_delete_file(uint32_t number) {
+    char name[12];
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+
+    snprintf(name, sizeof(name), "SD_%05luCSV", number % 100000UL);
+    int8_t result = dir_find(root_cluster, name, &found, &free_slot, &last_cluster);
+    if (result <= 0) {
+        return result == 0;
+    }
+
+    uint32_t first = dir_entry_cluster(&sector_buffer[found.index * 32]);
+    sector_buffer[found.index * 32] = 0xE5;
+    if (!sd_write_sector(found.sector, sector_buffer)) {
+        return false;
+    }
+    return first < 2 || fat_free_chain(first, true);
+}
+
+// Rotation due avant d'écrire une ligne de len octets (un fichier vide
+// reçoit toujours sa première ligne)
+static bool log_rotate_due(uint32_t cycle, uint16_t len) {
+    if (exfat) {
+        return false;  // Noms 8.3 et zone réservée: rotation propre à FAT16/32
+    }
+    uint32_t size = csv_next_seq * 512 + csv_byte_offset;
+    if (LOG_ROTATE_BYTES > 0 && size > 0 && size + len > LOG_ROTATE_BYTES) {
+        return true;
+    }
+    return LOG_ROTATE_CYCLES > 0 && log_first_cycle != LOG_CYCLE_UNKNOWN &&
+           cycle - log_first_cycle >= LOG_ROTATE_CYCLES;
+}
+
+/**
+ * Clôt le fichier actif et ouvre le suivant
+ *
+ * Le fichier clos garde sa taille exacte dans le répertoire; l'index n'est
+ * réécrit qu'avec la ligne suivante, une coupure entre les deux ramène au
+ * montage sur l'ancien fichier ou, via le parcours, sur le nouveau.
+ */
+static bool log_rotate(void) {
+    uint32_t start = micros();
+
+    if (!log_flush() || !fat_cache_flush() || !fat32_update_file_size()) {
+        return false;
+    }
+
+    log_set_file_number(log_file_number + 1);
+    log_first_cycle = LOG_CYCLE_UNKNOWN;
+    log_index_dirty = true;
+    csv_dir_loc.sector = 0;
+    csv_start_sector = 0;
+    csv_next_seq = 0;
+    csv_byte_offset = 0;
+    lines_since_size_update = 0;
+
+    // Carte de latence propre au fichier actif
+    memset(latency_map, 0, sizeof(latency_map));
+    latency_shift = 3;
+
+    if (!fat32_find_or_create_file()) {
+        return false;
+    }
+
+    if (LOG_ROTATE_KEEP > 0 && log_file_number > LOG_ROTATE_KEEP &&
+        !log_delete_file(log_file_number - LOG_ROTATE_KEEP)) {
+        return false;
+    }
+
+    fs_stats.log_rotations++;
+    fs_stats.log_rotate_time_us = micros() - start;
+    return true;
+}
+
+// =============================================================================
+// FICHIERS ANNEXES (TABLE DE HANDLES)
+// =============================================================================
+
+// Position de fin d'un fichier existant: taille et dernière suite de clusters
+static bool file_load(file_handle_t* h, const uint8_t* entry) {
+    h->first_cluster = dir_entry_cluster(entry);
+    h->size = get_le32(&entry[0x1C]);
+    h->size_on_disk = h->size;
+    h->run_logical = 0;
+    h->run_cluster = h->first_cluster;
+    h->run_length = 0;
+
+    uint32_t cluster = h->first_cluster;
+    uint32_t logical = 0;
+    while (cluster >= 2 && cluster < FAT32_EOC_MIN) {
+        if (logical >= cluster_count) {
+            return false;  // Chaîne bouclée
+        }
+        if (h->run_length > 0 && cluster == h->run_cluster + h->run_length) {
+            h->run_length++;
+        } else {
+            h->run_logical = logical;
+            h->run_cluster = cluster;
+            h->run_length = 1;
+        }
+        logical++;
+        if (!fat_get(cluster, &cluster)) {
+            return false;
+        }
+    }
+
+    // Taille au-delà de la chaîne: entrée incohérente, on n'y écrit pas
+    return (h->size + 511) / 512 <= logical * sectors_per_cluster;
+}
+
+// Trouve ou crée le fichier à la racine et charge sa position de fin
+static bool file_open_entry(file_handle_t* h) {
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = dir_find(root_cluster, h->name83, &found, &free_slot, &last_cluster);
+    if (result < 0) {
+        return false;
+    }
+
+    if (result > 0) {
+        const uint8_t* entry = &sector_buffer[found.index * 32];
+        if (entry[0x0B] & 0x10) {
+            return false;  // Répertoire
+        }
+        h->dir_loc = found;
+        return file_load(h, entry);
+    }
+
+    if (free_slot.sector == 0 && !dir_extend(last_cluster, &free_slot)) {
+        return false;
+    }
+
+    // Cluster alloué avant l'entrée, comme pour le journal
+    uint32_t cluster = fat_alloc_cluster(0, 0);
+    if (cluster == 0 || !fat_cache_flush() ||
+        !dir_write_entry(&free_slot, h->name83, cluster, 0)) {
+        return false;
+    }
+
+    h->dir_loc = free_slot;
+    h->first_cluster = cluster;
+    h->size = 0;
+    h->size_on_disk = 0;
+    h->run_logical = 0;
+    h->run_cluster = cluster;
+    h->run_length = 1;
+    return true;
+}
+
+// Réécrit premier cluster et taille dans l'entrée (dates et attributs conservés)
+static bool file_write_entry(file_handle_t* h) {
+    if (!sd_read_sector(h->dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+
+    uint8_t* entry = &sector_buffer[h->dir_loc.index * 32];
+    put_le16(&entry[0x14], (uint16_t)(h->first_cluster >> 16));
+    put_le16(&entry[0x1A], (uint16_t)h->first_cluster);
+    put_le32(&entry[0x1C], h->size);
+    if (!sd_write_sector(h->dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+
+    h->size_on_disk = h->size;
+    return true;
+}
+
+/**
+ * Revérifie un handle après un montage: une lecture si l'entrée n'a pas
+ * changé, sinon nouvelle recherche (carte changée, fichier modifié sur PC
+ * ou démontage interrompu avant le commit)
+ */
+static bool file_check(file_handle_t* h) {
+    if (h->checked) {
+        return true;
+    }
+
+    if (!sd_read_sector(h->dir_loc.sector, sector_buffer)) {
+        return false;
+    }
+    const uint8_t* entry = &sector_buffer[h->dir_loc.index * 32];
+    if (memcmp(entry, h->name83, 11) != 0 || dir_entry_cluster(entry) != h->first_cluster ||
+        get_le32(&entry[0x1C]) != h->size_on_disk || h->size != h->size_on_disk) {
+        if (!file_open_entry(h)) {
+            return false;
+        }
+    }
+
+    h->checked = true;
+    return true;
+}
+
+// Ajoute un cluster en fin de chaîne, le suivant physiquement de préférence
+static bool file_grow(file_handle_t* h) {
+    // Fichier vide créé sur PC: l'entrée doit désigner le cluster avant les données
+    if (h->run_length == 0) {
+        uint32_t cluster = fat_alloc_cluster(0, 0);
+        if (cluster == 0) {
+            return false;
+        }
+        h->first_cluster = cluster;
+        h->run_cluster = cluster;
+        h->run_length = 1;
+        return fat_cache_flush() && file_write_entry(h);
+    }
+
+    uint32_t last = h->run_cluster + h->run_length - 1;
+    uint32_t cluster = fat_alloc_cluster(last, last + 1);
+    if (cluster == 0) {
+        return false;
+    }
+
+    if (cluster == last + 1) {
+        h->run_length++;
+    } else {
+        h->run_logical += h->run_length;
+        h->run_cluster = cluster;
+        h->run_length = 1;
+    }
+    return true;
+}
+
+/**
+ * Ajoute du texte en fin de fichier annexe, à cheval sur plusieurs secteurs
+ *
+ * Un secteur n'est écrit que plein, quand le journal ou un autre fichier
+ * reprend le secteur de fin, ou au commit. Si l'écriture d'un secteur
+ * plein échoue, le dernier morceau est retiré et peut être rejoué.
+ */
+static bool file_append(int8_t file, const char* text, uint16_t len) {
+    file_handle_t* h = &file_handles[file];
+
+    while (len > 0) {
+        uint16_t offset = h->size % 512;
+        if (offset == 0 && file_lba(h, h->size / 512) == 0 && !file_grow(h)) {
+            return false;  // Volume plein
+        }
+        if (!tail_claim(file)) {
+            return false;
+        }
+        if (offset == 0) {
+            memset(log_tail, 0, 512);
+        }
+
+        uint16_t chunk = (len < 512 - offset) ? len : 512 - offset;
+        memcpy(&log_tail[offset], text, chunk);
+        file_tail_dirty = true;
+        h->size += chunk;
+
+        if (h->size % 512 == 0 && !file_tail_flush(h)) {
+            h->size -= chunk;
+            return false;
+        }
+        text += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+// Commit: secteur de fin, chaîne FAT, puis taille visible dans le répertoire
+static bool file_sync(int8_t file) {
+    file_handle_t* h = &file_handles[file];
+
+    if (log_tail_owner == file && !file_tail_flush(h)) {
+        return false;
+    }
+    if (!fat_cache_flush()) {
+        return false;
+    }
+    return h->size == h->size_on_disk || file_write_entry(h);
+}
+
+// Commit de tous les handles utilisés depuis le montage
+static bool file_sync_all(void) {
+    bool ok = true;
+    for (int8_t i = 0; i < FILE_HANDLE_COUNT; i++) {
+        if (file_handles[i].used && file_handles[i].checked && !file_sync(i)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Handle ouvert et utilisable sur le volume monté
+static sd_error_t file_validate(int8_t file) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (exfat) {
+        return ERR_FAT_VOLUME_FAILED;  // Fichiers à chaîne FAT seulement
+    }
+    if (file < 0 || file >= FILE_HANDLE_COUNT || !file_handles[file].used) {
+        return ERR_FILE_OPEN_FAILED;
+    }
+    return file_check(&file_handles[file]) ? ERR_NONE : ERR_FILE_OPEN_FAILED;
+}
+
+// =============================================================================
+// FORMATAGE RAPIDE (MBR + FAT32 ALIGNÉS)
+// =============================================================================
+
+#define FORMAT_MIN_RESERVED     32
+#define FORMAT_ALIGN_MAX        32768UL     // Zone réservée sur 16 bits
+#define FAT32_MIN_CLUSTERS      65525UL
+
+/**
+ * Calcule la géométrie: partition et début des données alignés sur l'AU,
+ * clusters de FORMAT_CLUSTER_SECTORS réduits jusqu'au minimum FAT32
+ */
+static bool format_layout(sd_format_info_t* info) {
+    uint32_t align = card_status.au_sectors ? card_status.au_sectors : FORMAT_ALIGN_SECTORS;
+    if (align > FORMAT_ALIGN_MAX) {
+        align = FORMAT_ALIGN_MAX;
+    }
+    while (align > 1 && align * 16 > card_sectors) {
+        align >>= 1;
+    }
+
+    info->align_sectors = align;
+    info->partition_start = align;
+    info->partition_sectors = card_sectors - align;
+
+    uint32_t spc = FORMAT_CLUSTER_SECTORS;
+    for (;;) {
+        uint32_t part = info->partition_sectors;
+        uint32_t fat = (((part - FORMAT_MIN_RESERVED) / spc + 2) * 4 + 511) / 512;
+        uint32_t data_off = (FORMAT_MIN_RESERVED + 2 * fat + align - 1) / align * align;
+
+        info->cluster_sectors = spc;
+        info->fat_sectors = fat;
+        info->reserved_sectors = data_off - 2 * fat;
+        info->data_start = info->partition_start + data_off;
+        info->clusters = (part > data_off) ? (part - data_off) / spc : 0;
+
+        if (info->clusters >= FAT32_MIN_CLUSTERS || spc == 1) {
+            break;
+        }
+        spc >>= 1;
+    }
+
+    if (info->clusters < FAT32_MIN_CLUSTERS) {
+        return false;  // Carte trop petite pour FAT32
+    }
+
+    uint32_t log_clusters = (FORMAT_LOG_PREALLOC_SECTORS + info->cluster_sectors - 1) / info->cluster_sectors;
+    if (log_clusters > info->clusters / 2) {
+        log_clusters = info->clusters / 2;
+    }
+    if (log_clusters == 0) {
+        log_clusters = 1;
+    }
+    info->log_sectors = log_clusters * info->cluster_sectors;
+    return true;
+}
+
+// Secteur i de la FAT: racine au cluster 2, journal préalloué à partir du 3
+static void format_fat_sector(uint32_t index, uint32_t log_last) {
+    memset(sector_buffer, 0, 512);
+
+    for (uint8_t i = 0; i < 128; i++) {
+        uint32_t cluster = index * 128 + i;
+        uint32_t value = 0;
+
+        if (cluster == 0) {
+            value = 0x0FFFFFF8UL;
+        } else if (cluster == 1 || cluster == 2 || cluster == log_last) {
+            value = FAT32_EOC;
+        } else if (cluster >= 3 && cluster < log_last) {
+            value = cluster + 1;
+        }
+        put_le32(&sector_buffer[i * 4], value);
+    }
+}
+
+static void format_boot_sector(const sd_format_info_t* info) {
+    memset(sector_buffer, 0, 512);
+
+    sector_buffer[0] = 0xEB;
+    sector_buffer[1] = 0x58;
+    sector_buffer[2] = 0x90;
+    memcpy(&sector_buffer[3], "SDSTRESS", 8);
+    sector_buffer[0x0B] = 0x00;                         // 512 octets par secteur
+    sector_buffer[0x0C] = 0x02;
+    sector_buffer[0x0D] = info->cluster_sectors;
+    sector_buffer[0x0E] = info->reserved_sectors & 0xFF;
+    sector_buffer[0x0F] = info->reserved_sectors >> 8;
+    sector_buffer[0x10] = 2;                            // Copies de la FAT
+    sector_buffer[0x15] = 0xF8;                         // Disque fixe
+    sector_buffer[0x18] = 63;                           // Géométrie CHS fictive
+    sector_buffer[0x1A] = 255;
+    put_le32(&sector_buffer[0x1C], info->partition_start);
+    put_le32(&sector_buffer[0x20], info->partition_sectors);
+    put_le32(&sector_buffer[0x24], info->fat_sectors);
+    put_le32(&sector_buffer[0x2C], 2);                  // Cluster racine
+    sector_buffer[0x30] = 1;                            // FSInfo
+    sector_buffer[0x32] = 6;                            // Copie du secteur de boot
+    sector_buffer[0x40] = 0x80;
+    sector_buffer[0x42] = 0x29;
+    put_le32(&sector_buffer[0x43], card_id.serial ^ micros());
+    memcpy(&sector_buffer[0x47], "SD STRESS  ", 11);
+    memcpy(&sector_buffer[0x52], "FAT32   ", 8);
+    sector_buffer[510] = 0x55;
+    sector_buffer[511] = 0xAA;
+}
+
+static void format_fsinfo_sector(const sd_format_info_t* info) {
+    uint32_t log_clusters = info->log_sectors / info->cluster_sectors;
+
+    memset(sector_buffer, 0, 512);
+    put_le32(&sector_buffer[0], FSINFO_LEAD_SIG);
+    put_le32(&sector_buffer[484], FSINFO_STRUCT_SIG);
+    put_le32(&sector_buffer[488], info->clusters - 1 - log_clusters);
+    put_le32(&sector_buffer[492], 3 + log_clusters);
+    put_le32(&sector_buffer[508], FSINFO_TRAIL_SIG);
+}
+
+// Table de partition: une entrée FAT32 LBA (0x0C) couvrant la partition
+static void format_mbr_sector(const sd_format_info_t* info) {
+    memset(sector_buffer, 0, 512);
+
+    uint8_t* entry = &sector_buffer[0x1BE];
+    entry[1] = 0xFE;                                    // CHS hors limites: LBA seul
+    entry[2] = 0xFF;
+    entry[3] = 0xFF;
+    entry[4] = 0x0C;
+    entry[5] = 0xFE;
+    entry[6] = 0xFF;
+    entry[7] = 0xFF;
+    put_le32(&entry[8], info->partition_start);
+    put_le32(&entry[12], info->partition_sectors);
+    sector_buffer[510] = 0x55;
+    sector_buffer[511] = 0xAA;
+}
+
+// Écrit count secteurs consécutifs d'un seul flux multi-bloc
+static bool format_write_zeros(uint32_t lba, uint32_t count) {
+    memset(sector_buffer, 0, 512);
+    if (!sd_write_multi_begin(lba)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!sd_write_multi_next(sector_buffer)) {
+            return false;
+        }
+    }
+    return sd_write_multi_end();
+}
+
+/**
+ * Écrit tout le volume: FAT, répertoire racine et journal, FSInfo, secteurs
+ * de boot, puis le MBR en dernier. Un formatage interrompu est à relancer.
+ */
+static bool format_write(const sd_format_info_t* info) {
+    uint32_t vbr = info->partition_start;
+    uint32_t log_last = 2 + info->log_sectors / info->cluster_sectors;
+
+    for (uint8_t copy = 0; copy < 2; copy++) {
+        if (!sd_write_multi_begin(vbr + info->reserved_sectors + copy * info->fat_sectors)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < info->fat_sectors; i++) {
+            format_fat_sector(i, log_last);
+            if (!sd_write_multi_next(sector_buffer)) {
+                return false;
+            }
+        }
+        if (!sd_write_multi_end()) {
+            return false;
+        }
+    }
+
+    // Racine (cluster 2) et premier cluster du journal: aucun en-tête résiduel
+    if (!format_write_zeros(info->data_start, 2 * info->cluster_sectors)) {
+        return false;
+    }
+    memset(sector_buffer, 0, 512);
+    dir_fill_entry(&sector_buffer[0], "SD STRESS  ", 0x08, 0, 0);
+    dir_fill_entry(&sector_buffer[32], csv_name83, 0x20, 3, 0);
+    if (!sd_write_sector(info->data_start, sector_buffer)) {
+        return false;
+    }
+
+    // Index de rotation et checkpoints effacés, secteurs de boot libres à zéro
+    if (!format_write_zeros(vbr + info->reserved_sectors - 3, 3) ||
+        !format_write_zeros(vbr + 2, 4)) {
+        return false;
+    }
+
+    format_fsinfo_sector(info);
+    if (!sd_write_sector(vbr + 1, sector_buffer) || !sd_write_sector(vbr + 7, sector_buffer)) {
+        return false;
+    }
+    format_boot_sector(info);
+    if (!sd_write_sector(vbr + 6, sector_buffer) || !sd_write_sector(vbr, sector_buffer)) {
+        return false;
+    }
+
+    format_mbr_sector(info);
+    return sd_write_sector(0, sector_buffer);
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+bool sd_controller_init(void) {
+    spi_init();
+    current_spi_freq = SD_SPI_FREQUENCY;
+    sd_initialized = false;
+    sd_mounted = false;
+    card_type = CT_NONE;
+    header_written = false;
+    csv_start_sector = 0;
+    csv_next_seq = 0;
+    csv_byte_offset = 0;
+    csv_dir_loc.sector = 0;
+    csv_first_cluster = 0;
+    log_extent_count = 0;
+    scratch_dir_loc.sector = 0;
+    meta_dir_cluster = 0;
+    volume_cached = false;
+    memcpy(csv_name83, CSV_FILENAME_83, sizeof(csv_name83));
+    log_file_number = 0;
+    log_first_cycle = LOG_CYCLE_UNKNOWN;
+    log_index_dirty = false;
+    memset(&fs_stats, 0, sizeof(fs_stats));
+    memset(latency_map, 0, sizeof(latency_map));
+    latency_shift = 3;
+
+    return true;
+}
+
+sd_error_t sd_mount(uint32_t freq_hz) {
+    uint32_t start_time = micros();
+
+    // Une fréquence demandée prime sur celle du profil de la carte
+    spi_freq_forced = (freq_hz > 0);
+    if (freq_hz > 0) {
+        current_spi_freq = freq_hz;
+    }
+
+    if (sd_mounted) {
+        sd_unmount();
+    }
+
+    // Phase 1: Initialisation de la carte
+    sd_error_t err = sd_card_init();
+    if (err != ERR_NONE) {
+        last_init_time_us = micros() - start_time;
+        return err;
+    }
+
+    // Phase 2: Monter le système de fichiers FAT16/FAT32
+    if (!fat32_read_bpb()) {
+        last_init_time_us = micros() - start_time;
+        return ERR_FAT_VOLUME_FAILED;
+    }
+
+    fsinfo_load();
+    fat_cache_invalidate();
+    log_tail_dirty = false;
+    log_tail_lines = 0;
+    file_tail_dirty = false;
+    log_tail_owner = TAIL_OWNER_NONE;
+    for (uint8_t i = 0; i < FILE_HANDLE_COUNT; i++) {
+        file_handles[i].checked = false;  // Carte peut-être changée ou modifiée
+    }
+
+    // Journal tournant: fichier actif lu dans l'index au premier montage,
+    // puis entrée mémorisée en RAM
+    // Un échec redemande la détection complète du volume au montage suivant
+    if (LOG_ROTATE_ENABLED && csv_dir_loc.sector == 0 && !log_index_load() && !log_scan_latest()) {
+        volume_cached = false;
+        last_init_time_us = micros() - start_time;
+        return ERR_FILE_OPEN_FAILED;
+    }
+
+    // Trouver ou créer le fichier CSV
+    if (!fat32_find_or_create_file()) {
+        volume_cached = false;
+        last_init_time_us = micros() - start_time;
+        return ERR_FILE_OPEN_FAILED;
+    }
+    if (LOG_ROTATE_ENABLED && !fs_stats.dir_cache_hit) {
+        log_index_dirty = true;
+    }
+
+    sd_mounted = true;
+    last_init_time_us = micros() - start_time;
+    return ERR_NONE;
+}
+
+sd_error_t sd_unmount(void) {
+    sd_error_t err = ERR_NONE;
+
+    // Fichiers annexes, chaîne du fichier, copies de la FAT, taille visible
+    // sur PC, puis FSInfo
+    if (sd_mounted && (!file_sync_all() || !log_flush() || !fat_cache_flush() || !fat_mirror_sync() ||
+                       !fat32_update_file_size() || !fsinfo_flush())) {
+        err = ERR_FILE_CLOSE_FAILED;
+        log_extent_count = 0;  // Chaîne sur la carte incertaine: relire au montage
+    }
+
+    sd_mounted = false;
+    spi_deselect();
+    return err;
+}
+
+bool sd_is_mounted(void) {
+    return sd_mounted;
+}
+
+// Formate la ligne du cycle dans line (CSV_LINE_MAX_SIZE octets) et l'ajoute au journal
+static sd_error_t log_write_record(char* line, uint32_t cycle, const cycle_result_t* result,
+                                   uint32_t timestamp_ms) {
+    uint32_t start_time = micros();
+
+    // Préparer la ligne
+    int len = snprintf(line, CSV_LINE_MAX_SIZE,
+        "%lu,%lu,%s,%d,%lu,%lu,%lu,%lu,%lu,%lu,%08lX\n",
+        timestamp_ms,
         cycle,
         result->success ? "OK" : "FAIL",
         (int)result->error_code,
@@ -626,54 +4055,197 @@ sd_error_t sd_write_csv_line(uint32_t cycle, const cycle_result_t* result, uint3
         result->write_time_us,
         result->spi_freq_used,
         GET_BATTERY_MV(),
-        GET_FREE_HEAP()
+        GET_FREE_HEAP(),
+        boot_epoch,
+        card_id.serial
     );
 
-    len += data_len;
+    if (len < 0 || len >= CSV_LINE_MAX_SIZE) {
+        last_write_time_us = micros() - start_time;
+        return ERR_BUFFER_OVERFLOW;
+    }
+
+    // Rotation avant la ligne qui dépasserait le seuil, puis index à jour
+    if (LOG_ROTATE_ENABLED) {
+        if (log_rotate_due(cycle, len) && !log_rotate()) {
+            last_write_time_us = micros() - start_time;
+            return ERR_FILE_WRITE_FAILED;
+        }
+        if (log_first_cycle == LOG_CYCLE_UNKNOWN) {
+            log_first_cycle = cycle;
+            log_index_dirty = true;
+        }
+        if (log_index_dirty && !log_index_store()) {
+            last_write_time_us = micros() - start_time;
+            return ERR_FILE_WRITE_FAILED;
+        }
+    }
+
+    // Écrire l'en-tête si c'est le premier write
+    if (!header_written) {
+        if (!log_append(CSV_HEADER, sizeof(CSV_HEADER) - 1)) {
+            last_write_time_us = micros() - start_time;
+            return ERR_FILE_WRITE_FAILED;
+        }
+        header_written = true;
+    }
+
+    if (!log_append(line, (uint16_t)len)) {
+        last_write_time_us = micros() - start_time;
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    // Mode continu: FAT et taille du répertoire mises à jour périodiquement
+    if (++lines_since_size_update >= CSV_SIZE_UPDATE_LINES) {
+        lines_since_size_update = 0;
+        if (!log_flush() || !fat_cache_flush() || !fat32_update_file_size()) {
+            last_write_time_us = micros() - start_time;
+            return ERR_FILE_WRITE_FAILED;
+        }
+    }
+
+    last_write_time_us = micros() - start_time;
+    return ERR_NONE;
+}
+
+sd_error_t sd_write_csv_line(uint32_t cycle, const cycle_result_t* result, uint32_t timestamp_ms) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
 
-    if (len < 0 || len >= (int)sizeof(line)) {
-        last_write_time_us = micros() - start_time;
-        return ERR_BUFFER_OVERFLOW;
+    // Ligne empruntée à l'arena: copiée dans le secteur de fin par log_append
+    ram_lease_t lease;
+    char* line = (char*)ram_lease(&lease, CSV_LINE_MAX_SIZE);
+    sd_error_t err = (line != nullptr) ?
+                     log_write_record(line, cycle, result, timestamp_ms) : ERR_BUFFER_OVERFLOW;
+    ram_release(&lease);
+    return err;
+}
+
+bool sd_get_resume_point(uint32_t* last_cycle, uint32_t* last_epoch) {
+    if (!sd_mounted) {
+        return false;
     }
 
-    // Lire le secteur actuel si on n'est pas au début
-    if (csv_byte_offset > 0) {
-        if (!sd_read_sector(csv_next_sector, sector_buffer)) {
-            last_write_time_us = micros() - start_time;
-            return ERR_FILE_WRITE_FAILED;
+    // Dernier secteur écrit et nombre d'octets utilisés
+    uint32_t sequence = csv_next_seq;
+    uint16_t end = csv_byte_offset;
+    if (end == 0) {
+        if (sequence == 0) return false;
+        sequence--;
+        end = 512;
+    }
+
+    // Le dernier enregistrement est presque toujours dans le secteur de fin
+    for (uint8_t i = 0; i < LOG_RESUME_MAX_SECTORS; i++) {
+        const uint8_t* buffer = sector_buffer;
+        if (sequence == csv_next_seq && csv_byte_offset > 0 && log_tail_owner == TAIL_OWNER_LOG) {
+            buffer = log_tail;
+        } else {
+            uint32_t lba = log_lba(sequence);
+            if (lba == 0 || !sd_read_sector(lba, sector_buffer)) {
+                return false;
+            }
         }
-    } else {
-        memset(sector_buffer, 0, 512);
+        if (log_parse_last_record(buffer, end, last_cycle, last_epoch)) {
+            return true;
+        }
+        if (sequence == 0) break;
+        sequence--;
+        end = 512;
     }
 
-    // Copier les données
-    uint16_t bytes_written = 0;
-    while (bytes_written < len) {
-        uint16_t space_in_sector = 512 - csv_byte_offset;
-        uint16_t to_write = (len - bytes_written < space_in_sector) ?
-                            (len - bytes_written) : space_in_sector;
+    return false;
+}
 
-        memcpy(&sector_buffer[csv_byte_offset], &line[bytes_written], to_write);
-        csv_byte_offset += to_write;
-        bytes_written += to_write;
+sd_error_t sd_write_checkpoint(const void* data, uint16_t len) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (len > 512 - sizeof(checkpoint_header_t) - sizeof(uint32_t)) {
+        return ERR_BUFFER_OVERFLOW;
+    }
+    if (reserved_sectors < CHECKPOINT_MIN_RESERVED) {
+        return ERR_FAT_VOLUME_FAILED;
+    }
 
-        // Écrire le secteur si plein ou terminé
-        if (csv_byte_offset >= 512 || bytes_written >= len) {
-            if (!sd_write_sector(csv_next_sector, sector_buffer)) {
-                last_write_time_us = micros() - start_time;
-                return ERR_FILE_WRITE_FAILED;
-            }
+    checkpoint_header_t header;
+    header.magic = CHECKPOINT_MAGIC;
+    header.sequence = checkpoint_sequence + 1;
+    header.length = len;
+    header.reserved = 0;
+
+    memset(sector_buffer, 0, 512);
+    memcpy(sector_buffer, &header, sizeof(header));
+    memcpy(&sector_buffer[sizeof(header)], data, len);
+    uint32_t crc = crc32_compute(sector_buffer, sizeof(header) + len);
+    memcpy(&sector_buffer[sizeof(header) + len], &crc, sizeof(crc));
+
+    // Alterne les slots: le précédent reste valide si cette écriture échoue
+    if (!sd_write_sector(checkpoint_sector(header.sequence & 1), sector_buffer)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
 
-            if (csv_byte_offset >= 512) {
-                csv_next_sector++;
-                csv_byte_offset = 0;
-                memset(sector_buffer, 0, 512);
-            }
+    checkpoint_sequence = header.sequence;
+    return ERR_NONE;
+}
+
+sd_error_t sd_read_checkpoint(void* data, uint16_t len) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (reserved_sectors < CHECKPOINT_MIN_RESERVED ||
+        len > 512 - sizeof(checkpoint_header_t) - sizeof(uint32_t)) {
+        return ERR_FAT_VOLUME_FAILED;
+    }
+
+    bool found = false;
+    uint32_t sequence;
+
+    for (uint8_t slot = 0; slot < 2; slot++) {
+        if (!checkpoint_read_slot(slot, len, &sequence)) {
+            continue;
+        }
+        if (!found || (int32_t)(sequence - checkpoint_sequence) > 0) {
+            memcpy(data, &sector_buffer[sizeof(checkpoint_header_t)], len);
+            checkpoint_sequence = sequence;
+            found = true;
         }
     }
 
-    last_write_time_us = micros() - start_time;
-    return ERR_NONE;
+    return found ? ERR_NONE : ERR_FILE_OPEN_FAILED;
+}
+
+sd_error_t sd_write_log_comment(const char* text) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+
+    ram_lease_t lease;
+    char* line = (char*)ram_lease(&lease, CSV_LINE_MAX_SIZE);
+    int len = (line != nullptr) ? snprintf(line, CSV_LINE_MAX_SIZE, "#%s\n", text) : -1;
+    sd_error_t err = ERR_BUFFER_OVERFLOW;
+    if (len >= 0 && len < CSV_LINE_MAX_SIZE) {
+        err = log_append(line, (uint16_t)len) ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+    }
+    ram_release(&lease);
+    return err;
+}
+
+uint8_t sd_get_spi_trace(sd_trace_entry_t* out, uint8_t max) {
+    uint8_t count = (spi_trace_count < max) ? spi_trace_count : max;
+    uint8_t index = (spi_trace_head + SD_TRACE_DEPTH - count) % SD_TRACE_DEPTH;
+
+    for (uint8_t i = 0; i < count; i++) {
+        out[i] = spi_trace[index];
+        index = (index + 1) % SD_TRACE_DEPTH;
+    }
+
+    return count;
+}
+
+void sd_set_boot_epoch(uint32_t epoch) {
+    boot_epoch = epoch;
 }
 
 sd_error_t sd_health_check(void) {
@@ -694,7 +4266,7 @@ uint32_t sd_get_current_frequency(void) {
 }
 
 bool sd_reduce_frequency(void) {
-    for (uint8_t i = 0; i < spi_freq_count; i++) {
+    for (uint8_t i = 0; i < SD_SPI_FREQ_COUNT; i++) {
         if (spi_freq_table[i] < current_spi_freq) {
             current_spi_freq = spi_freq_table[i];
             return true;
@@ -704,7 +4276,16 @@ bool sd_reduce_frequency(void) {
 }
 
 void sd_reset_frequency(void) {
-    current_spi_freq = SD_SPI_FREQUENCY;
+    current_spi_freq = base_spi_freq;
+}
+
+void sd_set_frequency(uint32_t freq_hz) {
+    current_spi_freq = freq_hz;
+}
+
+uint8_t sd_get_frequency_table(const uint32_t** table) {
+    *table = spi_freq_table;
+    return SD_SPI_FREQ_COUNT;
 }
 
 sd_error_t sd_get_card_info(char* card_type_str, uint32_t* card_size_mb) {
@@ -730,8 +4311,8 @@ sd_error_t sd_get_card_info(char* card_type_str, uint32_t* card_size_mb) {
     }
 
     if (card_size_mb != nullptr) {
-        // Estimation basée sur le total des secteurs
-        *card_size_mb = (total_sectors / 2048);  // sectors * 512 / 1024 / 1024
+        // Capacité du CSD, à défaut taille du volume FAT
+        *card_size_mb = (card_sectors > 0 ? card_sectors : total_sectors) / 2048;
     }
 
     return ERR_NONE;
@@ -744,3 +4325,472 @@ uint32_t sd_get_last_init_time_us(void) {
 uint32_t sd_get_last_write_time_us(void) {
     return last_write_time_us;
 }
+
+uint32_t sd_get_busy_time_us(void) {
+    return busy_time_us;
+}
+
+uint32_t sd_get_busy_max_us(void) {
+    return busy_max_us;
+}
+
+void sd_reset_busy_max(void) {
+    busy_max_us = 0;
+}
+
+void sd_get_fs_stats(sd_fs_stats_t* out) {
+    if (out != nullptr) {
+        *out = fs_stats;
+
+        uint32_t median = latency_median();
+        out->latency_slow_buckets = 0;
+        for (uint8_t i = 0; i < LATENCY_MAP_BUCKETS; i++) {
+            if (latency_is_slow(&latency_map[i], median)) {
+                out->latency_slow_buckets++;
+            }
+        }
+    }
+}
+
+uint8_t sd_get_latency_map(sd_latency_bucket_t* out, uint8_t max,
+                           uint32_t* bucket_sectors, uint32_t* median_us) {
+    uint32_t median = latency_median();
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < LATENCY_MAP_BUCKETS && count < max; i++) {
+        const latency_bucket_t* bucket = &latency_map[i];
+        if (bucket->writes == 0) continue;
+
+        uint32_t avg = bucket->busy_sum_us / bucket->writes;
+        out[count].first_sequence = (uint32_t)i << latency_shift;
+        out[count].writes = bucket->writes;
+        out[count].avg_busy_us = (avg > 0xFFFF) ? 0xFFFF : avg;
+        out[count].max_busy_us = bucket->busy_max_us;
+        out[count].slow = latency_is_slow(bucket, median);
+        count++;
+    }
+
+    *bucket_sectors = 1UL << latency_shift;
+    *median_us = median;
+    return count;
+}
+
+bool sd_get_card_status(sd_card_status_t* out) {
+    if (out != nullptr) {
+        *out = card_status;
+    }
+    return card_status.valid;
+}
+
+bool sd_get_card_id(sd_card_id_t* out) {
+    if (out != nullptr) {
+        *out = card_id;
+    }
+    return card_id.valid;
+}
+
+const card_profile_t* sd_get_card_profile(void) {
+    return card_profile;
+}
+
+sd_error_t sd_scratch_open(uint32_t sectors, uint32_t* first_sector) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (exfat) {
+        return ERR_FAT_VOLUME_FAILED;  // Fichiers à chaîne FAT seulement
+    }
+
+    uint32_t clusters = (sectors + sectors_per_cluster - 1) / sectors_per_cluster;
+
+    // Emplacement connu: une seule lecture pour le revalider
+    if (scratch_dir_loc.sector != 0 && scratch_sectors >= sectors) {
+        if (!sd_read_sector(scratch_dir_loc.sector, sector_buffer)) {
+            return ERR_FILE_OPEN_FAILED;
+        }
+        const uint8_t* entry = &sector_buffer[scratch_dir_loc.index * 32];
+        if (memcmp(entry, SCRATCH_FILENAME_83, 11) == 0 &&
+            dir_entry_cluster(entry) == scratch_first_cluster) {
+            *first_sector = cluster_to_sector(scratch_first_cluster);
+            return ERR_NONE;
+        }
+        scratch_dir_loc.sector = 0;
+    }
+
+    dir_loc_t found;
+    uint32_t first;
+    sd_error_t err = contig_file_open(SCRATCH_FILENAME_83, sectors, &found, &first);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    scratch_dir_loc = found;
+    scratch_first_cluster = first;
+    scratch_sectors = clusters * sectors_per_cluster;
+    *first_sector = cluster_to_sector(first);
+    return ERR_NONE;
+}
+
+sd_error_t sd_erase_sectors(uint32_t sector, uint32_t count) {
+    if (!sd_initialized) {
+        return ERR_SD_INIT_FAILED;
+    }
+    if (count == 0) {
+        return ERR_NONE;
+    }
+    return sd_erase_range(sector, count) ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
+
+sd_error_t sd_contig_file_open(const char* name83, uint32_t sectors, uint32_t* first_sector) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (exfat) {
+        return ERR_FAT_VOLUME_FAILED;  // Fichiers à chaîne FAT seulement
+    }
+
+    dir_loc_t loc;
+    uint32_t first;
+    sd_error_t err = contig_file_open(name83, sectors, &loc, &first);
+    if (err == ERR_NONE) {
+        *first_sector = cluster_to_sector(first);
+    }
+    return err;
+}
+
+sd_error_t sd_write_text_file(const char* name83, const char* text, uint32_t len) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (exfat) {
+        return ERR_FAT_VOLUME_FAILED;  // Fichiers à chaîne FAT seulement
+    }
+
+    uint32_t sectors = (len + 511) / 512;
+    dir_loc_t loc;
+    uint32_t first;
+    sd_error_t err = contig_file_open(name83, sectors, &loc, &first);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    uint32_t lba = cluster_to_sector(first);
+    for (uint32_t i = 0; i < sectors; i++) {
+        uint32_t chunk = (len - i * 512 < 512) ? len - i * 512 : 512;
+        memset(sector_buffer, 0, 512);
+        memcpy(sector_buffer, &text[i * 512], chunk);
+        if (!sd_write_sector(lba + i, sector_buffer)) {
+            return ERR_FILE_WRITE_FAILED;
+        }
+    }
+
+    // Taille réelle: les clusters en surplus restent dans la chaîne
+    if (!dir_write_entry(&loc, name83, first, len)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+    return ERR_NONE;
+}
+
+sd_error_t sd_file_open(const char* name83, int8_t* file) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (exfat) {
+        return ERR_FAT_VOLUME_FAILED;  // Fichiers à chaîne FAT seulement
+    }
+    if (memcmp(name83, csv_name83, 11) == 0) {
+        return ERR_FILE_OPEN_FAILED;   // Le journal a sa propre position
+    }
+
+    int8_t slot = -1;
+    for (int8_t i = 0; i < FILE_HANDLE_COUNT; i++) {
+        if (file_handles[i].used && memcmp(file_handles[i].name83, name83, 11) == 0) {
+            *file = i;
+            return ERR_NONE;
+        }
+        if (!file_handles[i].used && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return ERR_BUFFER_OVERFLOW;    // Table pleine
+    }
+
+    file_handle_t* h = &file_handles[slot];
+    memcpy(h->name83, name83, 11);
+    if (!file_open_entry(h)) {
+        return ERR_FILE_OPEN_FAILED;
+    }
+
+    h->used = true;
+    h->checked = true;
+    *file = slot;
+    return ERR_NONE;
+}
+
+sd_error_t sd_file_append(int8_t file, const char* text, uint16_t len) {
+    sd_error_t err = file_validate(file);
+    if (err != ERR_NONE) {
+        return err;
+    }
+    return file_append(file, text, len) ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
+
+sd_error_t sd_file_sync(int8_t file) {
+    sd_error_t err = file_validate(file);
+    if (err != ERR_NONE) {
+        return err;
+    }
+    return file_sync(file) ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
+
+sd_error_t sd_file_close(int8_t file) {
+    sd_error_t err = sd_file_sync(file);
+    if (file >= 0 && file < FILE_HANDLE_COUNT) {
+        if (log_tail_owner == file) {
+            log_tail_owner = TAIL_OWNER_NONE;
+            file_tail_dirty = false;
+        }
+        file_handles[file].used = false;
+    }
+    return err;
+}
+
+uint32_t sd_file_size(int8_t file) {
+    if (file < 0 || file >= FILE_HANDLE_COUNT || !file_handles[file].used) {
+        return 0;
+    }
+    return file_handles[file].size;
+}
+
+sd_error_t sd_meta_dir_open(const char* name83) {
+    if (!sd_mounted) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+    if (exfat) {
+        return ERR_FAT_VOLUME_FAILED;  // Fichiers à chaîne FAT seulement
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = dir_find(root_cluster, name83, &found, &free_slot, &last_cluster);
+    if (result < 0) {
+        return ERR_FILE_READ_FAILED;
+    }
+
+    if (result > 0) {
+        const uint8_t* entry = &sector_buffer[found.index * 32];
+        uint32_t cluster = dir_entry_cluster(entry);
+        if (!(entry[0x0B] & 0x10) || cluster < 2) {
+            return ERR_FILE_OPEN_FAILED;
+        }
+        meta_dir_cluster = cluster;
+        return ERR_NONE;
+    }
+
+    if (free_slot.sector == 0 && !dir_extend(last_cluster, &free_slot)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    // Cluster vide avec "." et ".." (0 = racine)
+    uint32_t cluster = fat_alloc_cluster(0, 0);
+    if (cluster == 0 || !fat_cache_flush()) {
+        return ERR_VOLUME_FULL;
+    }
+
+    memset(sector_buffer, 0, 512);
+    for (uint16_t s = 1; s < sectors_per_cluster; s++) {
+        if (!sd_write_sector(cluster_to_sector(cluster) + s, sector_buffer)) {
+            return ERR_FILE_WRITE_FAILED;
+        }
+    }
+    dir_fill_entry(&sector_buffer[0], ".          ", 0x10, cluster, 0);
+    dir_fill_entry(&sector_buffer[32], "..         ", 0x10, 0, 0);
+    if (!sd_write_sector(cluster_to_sector(cluster), sector_buffer)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    if (!sd_read_sector(free_slot.sector, sector_buffer)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+    dir_fill_entry(&sector_buffer[free_slot.index * 32], name83, 0x10, cluster, 0);
+    if (!sd_write_sector(free_slot.sector, sector_buffer)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    meta_dir_cluster = cluster;
+    return ERR_NONE;
+}
+
+bool sd_meta_dir_is_open(void) {
+    return sd_mounted && meta_dir_cluster != 0;
+}
+
+sd_error_t sd_meta_create(const char* name83, sd_meta_timing_t* t) {
+    if (!sd_mounted || meta_dir_cluster == 0) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = meta_lookup(name83, &found, &free_slot, &last_cluster, t);
+    if (result != 0) {
+        return (result < 0) ? ERR_FILE_READ_FAILED : ERR_FILE_EXISTS;
+    }
+
+    if (free_slot.sector == 0) {
+        uint32_t start = micros();
+        bool ok = dir_extend(last_cluster, &free_slot);
+        t->fat_us += micros() - start;
+        if (!ok) {
+            return ERR_FILE_WRITE_FAILED;
+        }
+    }
+
+    uint32_t start = micros();
+    bool ok = dir_write_entry(&free_slot, name83, 0, 0);
+    t->entry_us += micros() - start;
+    return ok ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
+
+sd_error_t sd_meta_append(const char* name83, uint32_t bytes, sd_meta_timing_t* t) {
+    if (!sd_mounted || meta_dir_cluster == 0) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = meta_lookup(name83, &found, &free_slot, &last_cluster, t);
+    if (result <= 0) {
+        return (result < 0) ? ERR_FILE_READ_FAILED : ERR_FILE_OPEN_FAILED;
+    }
+
+    const uint8_t* entry = &sector_buffer[found.index * 32];
+    uint32_t first = dir_entry_cluster(entry);
+    uint32_t size = get_le32(&entry[0x1C]);
+
+    if (!meta_append_data(&first, size, bytes, t)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    uint32_t start = micros();
+    bool ok = dir_write_entry(&found, name83, first, size + bytes);
+    t->entry_us += micros() - start;
+    return ok ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
+
+sd_error_t sd_meta_truncate(const char* name83, sd_meta_timing_t* t) {
+    if (!sd_mounted || meta_dir_cluster == 0) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = meta_lookup(name83, &found, &free_slot, &last_cluster, t);
+    if (result <= 0) {
+        return (result < 0) ? ERR_FILE_READ_FAILED : ERR_FILE_OPEN_FAILED;
+    }
+
+    // Entrée vidée avant la libération: au pire des clusters perdus
+    uint32_t first = dir_entry_cluster(&sector_buffer[found.index * 32]);
+    uint32_t start = micros();
+    bool ok = dir_write_entry(&found, name83, 0, 0);
+    t->entry_us += micros() - start;
+
+    if (!ok || !meta_free_chain(first, t)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+    return ERR_NONE;
+}
+
+sd_error_t sd_meta_rename(const char* from83, const char* to83, sd_meta_timing_t* t) {
+    if (!sd_mounted || meta_dir_cluster == 0) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = meta_lookup(to83, &found, &free_slot, &last_cluster, t);
+    if (result != 0) {
+        return (result < 0) ? ERR_FILE_READ_FAILED : ERR_FILE_EXISTS;
+    }
+    result = meta_lookup(from83, &found, &free_slot, &last_cluster, t);
+    if (result <= 0) {
+        return (result < 0) ? ERR_FILE_READ_FAILED : ERR_FILE_OPEN_FAILED;
+    }
+
+    // L'entrée est encore dans sector_buffer: seul le nom change
+    uint32_t start = micros();
+    memcpy(&sector_buffer[found.index * 32], to83, 11);
+    bool ok = sd_write_sector(found.sector, sector_buffer);
+    t->entry_us += micros() - start;
+    return ok ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
+
+sd_error_t sd_meta_delete(const char* name83, sd_meta_timing_t* t) {
+    if (!sd_mounted || meta_dir_cluster == 0) {
+        return ERR_SD_MOUNT_FAILED;
+    }
+
+    dir_loc_t found, free_slot;
+    uint32_t last_cluster;
+    int8_t result = meta_lookup(name83, &found, &free_slot, &last_cluster, t);
+    if (result <= 0) {
+        return (result < 0) ? ERR_FILE_READ_FAILED : ERR_FILE_OPEN_FAILED;
+    }
+
+    // Entrée marquée supprimée avant la libération: au pire des clusters perdus
+    uint32_t first = dir_entry_cluster(&sector_buffer[found.index * 32]);
+    uint32_t start = micros();
+    sector_buffer[found.index * 32] = 0xE5;
+    bool ok = sd_write_sector(found.sector, sector_buffer);
+    t->entry_us += micros() - start;
+
+    if (!ok || !meta_free_chain(first, t)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+    return ERR_NONE;
+}
+
+sd_error_t sd_format(sd_format_info_t* info) {
+    uint32_t start_time = micros();
+
+    memset(info, 0, sizeof(*info));
+    if (sd_mounted) {
+        sd_unmount();
+    }
+
+    sd_error_t err = sd_card_init();
+    if (err != ERR_NONE) {
+        return err;
+    }
+    if (!card_id.valid || card_sectors == 0) {
+        return ERR_SD_CARD_TYPE_UNKNOWN;
+    }
+    if (!format_layout(info)) {
+        return ERR_FAT_VOLUME_FAILED;
+    }
+
+    // Volume neuf: plus rien de l'ancien en RAM
+    if (LOG_ROTATE_ENABLED) {
+        log_set_file_number(1);
+    }
+    log_first_cycle = LOG_CYCLE_UNKNOWN;
+    log_index_dirty = false;
+    csv_dir_loc.sector = 0;
+    csv_start_sector = 0;
+    csv_next_seq = 0;
+    csv_byte_offset = 0;
+    log_extent_count = 0;
+    scratch_dir_loc.sector = 0;
+    meta_dir_cluster = 0;
+    volume_cached = false;
+    free_bitmap_valid = false;
+    fat_cache_invalidate();
+    memset(latency_map, 0, sizeof(latency_map));
+    latency_shift = 3;
+
+    bool ok = format_write(info);
+    info->time_us = micros() - start_time;
+    return ok ? ERR_NONE : ERR_FILE_WRITE_FAILED;
+}
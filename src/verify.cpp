@@ -0,0 +1,215 @@
+/**
+ * @file verify.cpp
+ * @brief Implémentation de la vérification par relecture
+ */
+
+#include "verify.h"
+#include "sd_controller.h"
+#include "crc32.h"
+#include "ram.h"
+
+// =============================================================================
+// FORMAT DU SECTEUR DE CONTRÔLE
+// =============================================================================
+
+// [0..3] magic, [4..7] séquence, [8..11] graine, [12..507] PRBS, [508..511] CRC-32
+#define VERIFY_MAGIC        0x46564453UL    // "SDVF"
+#define VERIFY_PRBS_OFFSET  12
+#define VERIFY_CRC_OFFSET   508
+
+/**
+ * Générateur du contenu attendu, octet par octet
+ * Sert à l'écriture comme à la comparaison: pas de second tampon de 512 o.
+ */
+typedef struct {
+    uint32_t sequence;
+    uint32_t seed;
+    uint32_t state;         // xorshift32
+    uint32_t word;          // Mot PRBS en cours
+    uint32_t crc;
+    uint16_t pos;
+} verify_stream_t;
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+static verify_stats_t stats;
+static uint8_t* io_buffer = nullptr;    // Secteur emprunté à l'arena pendant le cycle
+static uint32_t next_sequence = 0;
+static uint32_t written_freq[VERIFY_READBACK_SECTORS];  // Fréquence d'écriture par séquence % K
+
+// =============================================================================
+// FONCTIONS INTERNES
+// =============================================================================
+
+static void stream_begin(verify_stream_t* s, uint32_t sequence) {
+    s->sequence = sequence;
+    s->seed = (sequence * 0x9E3779B9UL) ^ 0xA5A5A5A5UL;
+    if (s->seed == 0) {
+        s->seed = 1;
+    }
+    s->state = s->seed;
+    s->word = 0;
+    s->crc = CRC32_INIT;
+    s->pos = 0;
+}
+
+static uint8_t stream_next(verify_stream_t* s) {
+    uint16_t i = s->pos++;
+    uint8_t value;
+
+    if (i < VERIFY_PRBS_OFFSET) {
+        uint32_t field = (i < 4) ? VERIFY_MAGIC : (i < 8) ? s->sequence : s->seed;
+        value = (uint8_t)(field >> (8 * (i % 4)));
+    } else if (i < VERIFY_CRC_OFFSET) {
+        if (i % 4 == 0) {
+            s->state ^= s->state << 13;
+            s->state ^= s->state >> 17;
+            s->state ^= s->state << 5;
+            s->word = s->state;
+        }
+        value = (uint8_t)(s->word >> (8 * (i % 4)));
+    } else {
+        return (uint8_t)((s->crc ^ 0xFFFFFFFFUL) >> (8 * (i % 4)));
+    }
+
+    s->crc = crc32_update(s->crc, &value, 1);
+    return value;
+}
+
+static uint32_t ring_lba(uint32_t base, uint32_t sequence) {
+    return base + WORKLOAD_SCRATCH_SECTORS + sequence % VERIFY_RING_SECTORS;
+}
+
+static verify_freq_point_t* freq_point(uint32_t freq_hz) {
+    for (uint8_t i = 0; i < VERIFY_FREQ_SLOTS; i++) {
+        if (stats.freq[i].freq_hz == freq_hz || stats.freq[i].freq_hz == 0) {
+            stats.freq[i].freq_hz = freq_hz;
+            return &stats.freq[i];
+        }
+    }
+    return nullptr;
+}
+
+// Compare le secteur relu au contenu attendu de la séquence
+static void check_sector(uint32_t sequence, uint32_t lba, uint8_t age) {
+    verify_stream_t s;
+    stream_begin(&s, sequence);
+
+    uint32_t bits = 0;
+    for (uint16_t i = 0; i < 512; i++) {
+        uint8_t diff = io_buffer[i] ^ stream_next(&s);
+        for (uint8_t b = 0; diff != 0; b++, diff >>= 1) {
+            if (diff & 1) {
+                stats.bit_errors[b]++;
+                bits++;
+            }
+        }
+    }
+
+    uint32_t stored_crc = (uint32_t)io_buffer[VERIFY_CRC_OFFSET] |
+                          ((uint32_t)io_buffer[VERIFY_CRC_OFFSET + 1] << 8) |
+                          ((uint32_t)io_buffer[VERIFY_CRC_OFFSET + 2] << 16) |
+                          ((uint32_t)io_buffer[VERIFY_CRC_OFFSET + 3] << 24);
+    if (crc32_compute(io_buffer, VERIFY_CRC_OFFSET) != stored_crc) {
+        stats.crc_failures++;
+    }
+
+    stats.sectors_read++;
+    verify_freq_point_t* point = freq_point(written_freq[sequence % VERIFY_READBACK_SECTORS]);
+    if (point != nullptr) {
+        point->sectors_read++;
+        point->bit_errors += bits;
+    }
+
+    if (bits > 0) {
+        stats.sectors_bad++;
+        stats.age_errors[age]++;
+        stats.last_bad_lba = lba;
+        if (point != nullptr) {
+            point->sectors_bad++;
+        }
+    }
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+void verify_init(void) {
+    memset(&stats, 0, sizeof(stats));
+    memset(written_freq, 0, sizeof(written_freq));
+    next_sequence = 0;
+}
+
+static sd_error_t run_cycle(void) {
+    uint32_t base;
+    sd_error_t err = sd_scratch_open(SCRATCH_FILE_SECTORS, &base);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    // Écriture du secteur de contrôle
+    uint32_t sequence = next_sequence;
+    verify_stream_t s;
+    stream_begin(&s, sequence);
+    for (uint16_t i = 0; i < 512; i++) {
+        io_buffer[i] = stream_next(&s);
+    }
+
+    uint32_t start = micros();
+    if (!sd_write_sector(ring_lba(base, sequence), io_buffer)) {
+        return ERR_FILE_WRITE_FAILED;
+    }
+    stats.write_time_us += micros() - start;
+    stats.write_bytes += 512;
+    stats.sectors_written++;
+    written_freq[sequence % VERIFY_READBACK_SECTORS] = sd_get_current_frequency();
+    next_sequence++;
+
+    // Relecture des K derniers, du plus ancien au plus récent
+    uint32_t count = (next_sequence < VERIFY_READBACK_SECTORS) ? next_sequence : VERIFY_READBACK_SECTORS;
+    uint32_t first = next_sequence - count;
+    bool multi = count > 1 &&
+                 first % VERIFY_RING_SECTORS + count <= VERIFY_RING_SECTORS;
+
+    start = micros();
+    if (multi && !sd_read_multi_begin(ring_lba(base, first))) {
+        return ERR_FILE_READ_FAILED;
+    }
+    uint32_t read_us = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t seq = first + i;
+        bool ok = multi ? sd_read_multi_next(io_buffer) : sd_read_sector(ring_lba(base, seq), io_buffer);
+        if (!ok) {
+            return ERR_FILE_READ_FAILED;  // Flux déjà clos par la couche SD
+        }
+
+        // Temps de comparaison exclu du débit de lecture
+        read_us += micros() - start;
+        check_sector(seq, ring_lba(base, seq), sequence - seq);
+        start = micros();
+    }
+    if (multi && !sd_read_multi_end()) {
+        return ERR_FILE_READ_FAILED;
+    }
+    read_us += micros() - start;
+
+    stats.read_time_us += read_us;
+    stats.read_bytes += count * 512;
+    return ERR_NONE;
+}
+
+sd_error_t verify_run_cycle(void) {
+    ram_lease_t lease;
+    io_buffer = (uint8_t*)ram_lease(&lease, 512);
+    sd_error_t err = (io_buffer != nullptr) ? run_cycle() : ERR_BUFFER_OVERFLOW;
+    ram_release(&lease);
+    io_buffer = nullptr;
+    return err;
+}
+
+const verify_stats_t* verify_get_stats(void) {
+    return &stats;
+}
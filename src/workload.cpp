@@ -0,0 +1,197 @@
+/**
+ * @file workload.cpp
+ * @brief Implémentation du générateur de charge d'E/S
+ */
+
+#include "workload.h"
+#include "sd_controller.h"
+#include "ram.h"
+
+// =============================================================================
+// VARIABLES GLOBALES
+// =============================================================================
+
+static const uint32_t workload_sizes[] = { WORKLOAD_SIZES };
+#define WORKLOAD_SIZE_COUNT (sizeof(workload_sizes) / sizeof(workload_sizes[0]))
+#define WORKLOAD_POINT_COUNT (WORKLOAD_SIZE_COUNT * WORKLOAD_PATTERN_COUNT)
+
+static workload_point_t points[WORKLOAD_POINT_COUNT];
+static uint32_t seq_offset[WORKLOAD_POINT_COUNT];  // Position du motif séquentiel (octets)
+static uint8_t* io_buffer = nullptr;    // Secteur emprunté à l'arena pendant le cycle
+static uint32_t rng_state = 1;
+static uint8_t fill_byte = 0;
+
+// =============================================================================
+// FONCTIONS INTERNES
+// =============================================================================
+
+// xorshift32: suffisant pour disperser les adresses, sans coût RAM
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Modifie une partie d'un secteur (lecture-modification-écriture)
+static bool write_partial(uint32_t sector, uint16_t offset, uint16_t len) {
+    if (!sd_read_sector(sector, io_buffer)) {
+        return false;
+    }
+    memset(&io_buffer[offset], fill_byte, len);
+    return sd_write_sector(sector, io_buffer);
+}
+
+static bool write_range(uint32_t base, uint32_t offset, uint32_t size) {
+    uint32_t sector = base + offset / 512;
+    uint16_t head = offset % 512;
+
+    // Secteur de tête partiel
+    if (head != 0 || size < 512) {
+        uint16_t len = (size < 512U - head) ? size : 512 - head;
+        if (!write_partial(sector, head, len)) {
+            return false;
+        }
+        sector++;
+        size -= len;
+    }
+
+    // Secteurs complets: multi-bloc dès deux secteurs
+    uint32_t full = size / 512;
+    memset(io_buffer, fill_byte, 512);
+    if (full == 1) {
+        if (!sd_write_sector(sector, io_buffer)) {
+            return false;
+        }
+    } else if (full > 1) {
+        if (!sd_write_multi_begin(sector)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < full; i++) {
+            if (!sd_write_multi_next(io_buffer)) {
+                return false;
+            }
+        }
+        if (!sd_write_multi_end()) {
+            return false;
+        }
+    }
+    sector += full;
+    size -= full * 512;
+
+    // Secteur de queue partiel
+    if (size > 0) {
+        return write_partial(sector, 0, size);
+    }
+    return true;
+}
+
+static bool read_range(uint32_t base, uint32_t offset, uint32_t size) {
+    uint32_t first = base + offset / 512;
+    uint32_t count = (offset % 512 + size + 511) / 512;
+
+    if (count == 1) {
+        return sd_read_sector(first, io_buffer);
+    }
+
+    if (!sd_read_multi_begin(first)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!sd_read_multi_next(io_buffer)) {
+            return false;
+        }
+    }
+    return sd_read_multi_end();
+}
+
+// =============================================================================
+// IMPLÉMENTATION API PUBLIQUE
+// =============================================================================
+
+void workload_init(void) {
+    memset(points, 0, sizeof(points));
+    memset(seq_offset, 0, sizeof(seq_offset));
+
+    for (uint8_t i = 0; i < WORKLOAD_POINT_COUNT; i++) {
+        points[i].size = workload_sizes[i / WORKLOAD_PATTERN_COUNT];
+        points[i].pattern = i % WORKLOAD_PATTERN_COUNT;
+    }
+
+    rng_state = micros() | 1;
+}
+
+static sd_error_t run_cycle(uint32_t cycle) {
+    uint32_t base;
+    sd_error_t err = sd_scratch_open(SCRATCH_FILE_SECTORS, &base);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    uint8_t index = cycle % WORKLOAD_POINT_COUNT;
+    workload_point_t* point = &points[index];
+    uint32_t region = (uint32_t)WORKLOAD_SCRATCH_SECTORS * 512;
+    uint32_t size = point->size;
+
+    if (size == 0 || size > region) {
+        return ERR_BUFFER_OVERFLOW;
+    }
+
+    for (uint8_t op = 0; op < WORKLOAD_OPS_PER_CYCLE; op++) {
+        uint32_t offset;
+
+        if (point->pattern == WORKLOAD_SEQUENTIAL) {
+            if (seq_offset[index] + size > region) {
+                seq_offset[index] = 0;
+            }
+            offset = seq_offset[index];
+            seq_offset[index] += size;
+        } else {
+            // Adresse alignée sur la taille de l'opération
+            offset = (rng_next() % (region / size)) * size;
+        }
+
+        bool is_read = (rng_next() % 100) < WORKLOAD_READ_PERCENT;
+        uint32_t start = micros();
+        bool ok;
+
+        if (is_read) {
+            ok = read_range(base, offset, size);
+        } else {
+            fill_byte++;
+            ok = write_range(base, offset, size);
+        }
+        uint32_t elapsed = micros() - start;
+
+        if (!ok) {
+            point->errors++;
+            return is_read ? ERR_FILE_READ_FAILED : ERR_FILE_WRITE_FAILED;
+        }
+
+        if (is_read) {
+            point->read_ops++;
+            point->read_bytes += size;
+            point->read_time_us += elapsed;
+        } else {
+            point->write_ops++;
+            point->write_bytes += size;
+            point->write_time_us += elapsed;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+sd_error_t workload_run_cycle(uint32_t cycle) {
+    ram_lease_t lease;
+    io_buffer = (uint8_t*)ram_lease(&lease, 512);
+    sd_error_t err = (io_buffer != nullptr) ? run_cycle(cycle) : ERR_BUFFER_OVERFLOW;
+    ram_release(&lease);
+    io_buffer = nullptr;
+    return err;
+}
+
+uint8_t workload_get_points(const workload_point_t** out) {
+    *out = points;
+    return WORKLOAD_POINT_COUNT;
+}